@@ -0,0 +1,115 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "benchmark/benchmark_common.h"
+#include "jwt_verify_lib/jwks.h"
+#include "test/test_common.h"
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+// The "n" of the first key of benchmark_common::kRs256Jwks.
+const char kRsaModulus[] =
+    "0YWnm_eplO9BFtXszMRQNL5UtZ8HJdTH2jK7vjs4XdLkPW7YBkkm_2xNgcaVpkW0VT2l4mU3"
+    "KftR-6s3Oa5Rnz5BrWEUkCTVVolR7VYksfqIB2I_x5yZHdOiomMTcm3DheUUCgbJRv5OKRnN"
+    "qszA4xHn3tA3Ry8VO3X7BgKZYAUh9fyZTFLlkeAh0-bLK5zvqCmKW5QgDIXSxUTJxPjZCgfx"
+    "1vmAfGqaJb-nvmrORXQ6L284c73DUL7mnt6wj3H6tVqPKA27j56N0TB1Hfx4ja6Slr8S4EB3"
+    "F1luYhATa1PKUSH8mYDW11HolzZmTQpRoLV8ZoHbHEaTfqX_aYahIw";
+
+// Builds a JWKS of num_keys RSA keys that only differ by their kid.
+std::string makeRsaJwks(int num_keys) {
+  std::string jwks = R"({"keys":[)";
+  for (int i = 0; i < num_keys; ++i) {
+    if (i > 0) jwks += ",";
+    jwks += R"({"kty":"RSA","alg":"RS256","use":"sig","kid":"key)" +
+            std::to_string(i) + R"(","n":")" + kRsaModulus +
+            R"(","e":"AQAB"})";
+  }
+  return jwks + "]}";
+}
+
+// Builds an X509 keyset of num_keys copies of the first certificate of
+// kPublicKeyX509, each under its own kid.
+std::string makeX509Jwks(int num_keys) {
+  const std::string certs = kPublicKeyX509;
+  const size_t begin = certs.find("\"-----BEGIN");
+  const std::string cert =
+      certs.substr(begin, certs.find('"', begin + 1) + 1 - begin);
+  std::string jwks = "{";
+  for (int i = 0; i < num_keys; ++i) {
+    if (i > 0) jwks += ",";
+    jwks += "\"key" + std::to_string(i) + "\":" + cert;
+  }
+  return jwks + "}";
+}
+
+void BM_CreateFromJwks(benchmark::State& state) {
+  const std::string jwks = makeRsaJwks(state.range(0));
+  for (auto _ : state) {
+    auto keys = Jwks::createFrom(jwks, Jwks::JWKS);
+    if (keys->getStatus() != Status::Ok) {
+      state.SkipWithError("the keyset is invalid");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateFromJwks)->RangeMultiplier(10)->Range(1, 10000);
+
+// Same as BM_CreateFromJwks when none of the keys changed.
+void BM_UpdateFromJwks(benchmark::State& state) {
+  const std::string jwks = makeRsaJwks(state.range(0));
+  auto previous = Jwks::createFrom(jwks, Jwks::JWKS);
+  for (auto _ : state) {
+    auto keys = Jwks::updateFrom(*previous, jwks);
+    if (keys->getStatus() != Status::Ok) {
+      state.SkipWithError("the keyset is invalid");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateFromJwks)->RangeMultiplier(10)->Range(1, 10000);
+
+void BM_CreateFromX509(benchmark::State& state) {
+  const std::string jwks = makeX509Jwks(state.range(0));
+  for (auto _ : state) {
+    auto keys = Jwks::createFrom(jwks, Jwks::JWKS);
+    if (keys->getStatus() != Status::Ok) {
+      state.SkipWithError("the keyset is invalid");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateFromX509)->RangeMultiplier(10)->Range(1, 10000);
+
+void BM_CreateFromPem(benchmark::State& state) {
+  for (auto _ : state) {
+    auto keys = Jwks::createFrom(benchmark_common::kRs256Pem, Jwks::PEM);
+    if (keys->getStatus() != Status::Ok) {
+      state.SkipWithError("the key is invalid");
+      break;
+    }
+  }
+}
+BENCHMARK(BM_CreateFromPem);
+
+}  // namespace
+}  // namespace jwt_verify
+}  // namespace google
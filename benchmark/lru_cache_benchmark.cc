@@ -0,0 +1,117 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "benchmark/benchmark.h"
+#include "simple_lru_cache/sharded_simple_lru_cache.h"
+#include "simple_lru_cache/simple_lru_cache.h"
+#include "simple_lru_cache/simple_lru_cache_inl.h"
+
+namespace google {
+namespace simple_lru_cache {
+namespace {
+
+constexpr int64_t kNumKeys = 1 << 16;
+
+typedef SimpleLRUCache<int64_t, int64_t> Cache;
+typedef ShardedSimpleLRUCache<int64_t, int64_t> ShardedCache;
+
+// A SimpleLRUCache is not thread safe, the callers share it under a mutex.
+struct LockedCache {
+  explicit LockedCache(int64_t units) : cache(units) {}
+  std::mutex mutex;
+  Cache cache;
+};
+
+// The caches are shared by the threads of a benchmark and never destroyed.
+// They are filled with all the keys that are looked up.
+LockedCache* lockedCache() {
+  static LockedCache* const cache = [] {
+    auto* cache = new LockedCache(kNumKeys);
+    for (int64_t k = 0; k < kNumKeys; ++k) {
+      cache->cache.insert(k, new int64_t(k), 1);
+    }
+    return cache;
+  }();
+  return cache;
+}
+
+ShardedCache* shardedCache() {
+  static ShardedCache* const cache = [] {
+    auto* cache = new ShardedCache(16, kNumKeys);
+    for (int64_t k = 0; k < kNumKeys; ++k) {
+      cache->insert(k, new int64_t(k), 1);
+    }
+    return cache;
+  }();
+  return cache;
+}
+
+// Each thread inserts its own keys, all above the keys that are looked up.
+int64_t firstInsertedKey() {
+  static std::atomic<int64_t> next_thread{1};
+  return next_thread.fetch_add(1) << 40;
+}
+
+void BM_LockedLookup(benchmark::State& state) {
+  LockedCache* cache = lockedCache();
+  int64_t i = 0;
+  for (auto _ : state) {
+    const int64_t k = (i++ * 7919) % kNumKeys;
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    int64_t* value = cache->cache.lookup(k);
+    benchmark::DoNotOptimize(value);
+    if (value != nullptr) cache->cache.release(k, value);
+  }
+}
+BENCHMARK(BM_LockedLookup)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_ShardedLookup(benchmark::State& state) {
+  ShardedCache* cache = shardedCache();
+  int64_t i = 0;
+  for (auto _ : state) {
+    ShardedCache::ScopedLookup lookup(cache, (i++ * 7919) % kNumKeys);
+    benchmark::DoNotOptimize(lookup.value());
+  }
+}
+BENCHMARK(BM_ShardedLookup)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_LockedInsert(benchmark::State& state) {
+  LockedCache* cache = lockedCache();
+  int64_t k = firstInsertedKey();
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    cache->cache.insert(k, new int64_t(k), 1);
+    ++k;
+  }
+}
+BENCHMARK(BM_LockedInsert)->ThreadRange(1, 8)->UseRealTime();
+
+void BM_ShardedInsert(benchmark::State& state) {
+  ShardedCache* cache = shardedCache();
+  int64_t k = firstInsertedKey();
+  for (auto _ : state) {
+    cache->insert(k, new int64_t(k), 1);
+    ++k;
+  }
+}
+BENCHMARK(BM_ShardedInsert)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
+}  // namespace simple_lru_cache
+}  // namespace google
@@ -0,0 +1,138 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"
+#include "benchmark/benchmark_common.h"
+#include "jwt_verify_lib/check_audience.h"
+#include "jwt_verify_lib/jwt_verification_cache.h"
+#include "jwt_verify_lib/verify.h"
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+using benchmark_common::AlgFixture;
+using benchmark_common::algFixtures;
+
+// Verifies the signature of an already parsed token.
+void BM_VerifyJwt(benchmark::State& state, const AlgFixture& fixture) {
+  auto jwks = Jwks::createFrom(fixture.jwks, Jwks::JWKS);
+  Jwt jwt;
+  if (jwks->getStatus() != Status::Ok ||
+      jwt.parseFromString(fixture.jwt) != Status::Ok ||
+      verifyJwtWithoutTimeChecking(jwt, *jwks) != Status::Ok) {
+    state.SkipWithError("the fixture does not verify");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(verifyJwtWithoutTimeChecking(jwt, *jwks));
+  }
+}
+
+// Parses the token then verifies it, as done for every request.
+void BM_ParseAndVerifyJwt(benchmark::State& state, const AlgFixture& fixture) {
+  auto jwks = Jwks::createFrom(fixture.jwks, Jwks::JWKS);
+  if (jwks->getStatus() != Status::Ok) {
+    state.SkipWithError("the fixture keyset is invalid");
+    return;
+  }
+  for (auto _ : state) {
+    Jwt jwt;
+    if (jwt.parseFromString(fixture.jwt) == Status::Ok) {
+      benchmark::DoNotOptimize(verifyJwtWithoutTimeChecking(jwt, *jwks));
+    }
+  }
+}
+
+// Same as BM_ParseAndVerifyJwt when the token is found in a
+// JwtVerificationCache.
+void BM_CachedVerifyJwt(benchmark::State& state, const AlgFixture& fixture) {
+  auto jwks = Jwks::createFrom(fixture.jwks, Jwks::JWKS);
+  JwtVerificationCache cache(1024);
+  // Built once, as from the config.
+  const CheckAudience audiences({});
+  if (jwks->getStatus() != Status::Ok ||
+      cache.verify(fixture.jwt, *jwks, audiences, 1) != Status::Ok) {
+    state.SkipWithError("the fixture does not verify");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(cache.verify(fixture.jwt, *jwks, audiences, 1));
+  }
+}
+
+// Verifies a batch of 64 copies of the token, per token.
+void BM_VerifyJwtBatch(benchmark::State& state, const AlgFixture& fixture) {
+  constexpr size_t kBatchSize = 64;
+  auto jwks = Jwks::createFrom(fixture.jwks, Jwks::JWKS);
+  Jwt jwt;
+  if (jwks->getStatus() != Status::Ok ||
+      jwt.parseFromString(fixture.jwt) != Status::Ok ||
+      verifyJwtWithoutTimeChecking(jwt, *jwks) != Status::Ok) {
+    state.SkipWithError("the fixture does not verify");
+    return;
+  }
+  const std::vector<const Jwt*> jwts(kBatchSize, &jwt);
+  std::vector<Status> out(kBatchSize);
+  for (auto _ : state) {
+    verifyJwtBatch(jwts, *jwks, 1, absl::MakeSpan(out));
+    benchmark::DoNotOptimize(out.data());
+  }
+  state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+
+bool registerAlgBenchmarks() {
+  for (const auto& fixture : algFixtures()) {
+    const std::string name = fixture.name;
+    benchmark::RegisterBenchmark(("BM_VerifyJwt/" + name).c_str(),
+                                 BM_VerifyJwt, fixture);
+    benchmark::RegisterBenchmark(("BM_ParseAndVerifyJwt/" + name).c_str(),
+                                 BM_ParseAndVerifyJwt, fixture);
+    benchmark::RegisterBenchmark(("BM_CachedVerifyJwt/" + name).c_str(),
+                                 BM_CachedVerifyJwt, fixture);
+    benchmark::RegisterBenchmark(("BM_VerifyJwtBatch/" + name).c_str(),
+                                 BM_VerifyJwtBatch, fixture);
+  }
+  return true;
+}
+const bool alg_benchmarks_registered = registerAlgBenchmarks();
+
+// Checks a token audience against range(0) allowed audiences, the token
+// audience being the last one allowed.
+void BM_CheckAudience(benchmark::State& state) {
+  std::vector<std::string> config_audiences;
+  for (int i = 0; i < state.range(0); ++i) {
+    config_audiences.push_back("https://aud" + std::to_string(i) +
+                               ".example.com/");
+  }
+  CheckAudience check(config_audiences);
+  const std::vector<std::string> jwt_audiences = {
+      "aud" + std::to_string(state.range(0) - 1) + ".example.com"};
+  if (!check.areAudiencesAllowed(jwt_audiences)) {
+    state.SkipWithError("the audience is not allowed");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(check.areAudiencesAllowed(jwt_audiences));
+  }
+}
+BENCHMARK(BM_CheckAudience)->Range(1, 64);
+
+}  // namespace
+}  // namespace jwt_verify
+}  // namespace google
@@ -0,0 +1,54 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace google {
+namespace jwt_verify {
+
+// Decoding of base64url, as used by JWT and JWK. It accepts and rejects the
+// same inputs as absl::WebSafeBase64Unescape: the padding is optional, but
+// must be complete if present, and whitespace is skipped. The blocks without
+// padding or whitespace are decoded with SSE2, SSSE3, AVX2 or NEON when the
+// build enables them.
+
+// Return the maximum size of the bytes decoded from an input of size len.
+inline size_t base64UrlDecodedMaxSize(size_t len) { return (len + 3) / 4 * 3; }
+
+/**
+ * Decode base64url into a buffer of the caller.
+ * @param in the base64url input.
+ * @param out receives the bytes, it must have room for
+ * base64UrlDecodedMaxSize(in.size()) bytes.
+ * @param out_len receives the number of bytes decoded.
+ * @return false if in isn't valid base64url, out is then unspecified.
+ */
+bool base64UrlDecode(absl::string_view in, uint8_t* out, size_t* out_len);
+
+/**
+ * Decode base64url.
+ * @param in the base64url input.
+ * @param out receives the bytes, it is cleared if in isn't valid.
+ * @return false if in isn't valid base64url.
+ */
+bool base64UrlDecode(absl::string_view in, std::string* out);
+
+}  // namespace jwt_verify
+}  // namespace google
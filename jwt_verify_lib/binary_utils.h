@@ -0,0 +1,64 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include "absl/strings/string_view.h"
+
+namespace google {
+namespace jwt_verify {
+
+// Helpers for the binary formats of keysets, the integers are little-endian
+// and the strings are prefixed by their length as a uint32.
+
+// Append a uint32 to out.
+void appendUInt32(uint32_t value, std::string* out);
+
+// Append a length-prefixed string to out.
+void appendBytes(absl::string_view bytes, std::string* out);
+
+// Reads the binary formats, a read fails if the data is too short.
+class BinaryReader {
+ public:
+  explicit BinaryReader(absl::string_view data) : data_(data) {}
+
+  // Return true if all the data was read.
+  bool empty() const { return data_.empty(); }
+
+  // Return the number of bytes not read yet.
+  size_t remaining() const { return data_.size(); }
+
+  // Read length bytes, value points to the data.
+  bool readBytes(size_t length, absl::string_view* value);
+
+  bool readUInt8(uint8_t* value);
+
+  bool readUInt32(uint32_t* value);
+
+  // Read a length-prefixed string, value points to the data.
+  bool readString(absl::string_view* value);
+
+  // Read a length-prefixed string.
+  bool readString(std::string* value);
+
+ private:
+  absl::string_view data_;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -15,10 +15,10 @@
 #pragma once
 
 #include <memory>
-#include <set>
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_set.h"
 #include "jwt_verify_lib/status.h"
 
 namespace google {
@@ -30,6 +30,9 @@ namespace jwt_verify {
  * easily add wrong scheme and tailing slash to cause mis-match.
  * In this implemeation, scheme portion of URI and tailing slash is removed
  * before comparison.
+ *
+ * The configured audiences are sanitized once, so an object built once can be
+ * reused for many tokens; checking a token doesn't allocate.
  */
 class CheckAudience {
  public:
@@ -43,8 +46,8 @@ class CheckAudience {
   bool empty() const { return config_audiences_.empty(); }
 
  private:
-  // configured audiences;
-  std::set<std::string> config_audiences_;
+  // configured audiences, sanitized. Looked up with absl::string_view.
+  absl::flat_hash_set<std::string> config_audiences_;
 };
 
 typedef std::unique_ptr<CheckAudience> CheckAudiencePtr;
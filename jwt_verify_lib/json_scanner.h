@@ -0,0 +1,139 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * A pull based JSON tokenizer for a JSON object, the same kind of document
+ * that is parsed into a google::protobuf::Struct.
+ *
+ * It accepts exactly the documents that JsonStringToMessage accepts for a
+ * Struct, including its leniencies (single quoted strings, unquoted keys,
+ * trailing commas) and its restrictions (duplicate keys, invalid UTF-8,
+ * numbers out of the range of double, nesting depth), so callers can extract
+ * fields without building a Struct and still report the same errors.
+ *
+ * Example:
+ *   JsonScanner scanner(json);
+ *   for (auto token = scanner.next(); token != JsonScanner::End;
+ *        token = scanner.next()) {
+ *     if (token == JsonScanner::Error) { ... }
+ *   }
+ */
+class JsonScanner {
+ public:
+  enum Token {
+    BeginObject,
+    EndObject,
+    BeginArray,
+    EndArray,
+    // An object key, read it with str().
+    Key,
+    // A string value, read it with str().
+    String,
+    // A number value, read it with number().
+    Number,
+    // A boolean value, read it with boolean().
+    Bool,
+    Null,
+    // The top level object was closed and only whitespace follows.
+    End,
+    // The document is not valid. Once returned, next() keeps returning it.
+    Error,
+  };
+
+  /**
+   * Creates a scanner for json, which must outlive the scanner.
+   */
+  explicit JsonScanner(absl::string_view json);
+
+  /**
+   * Reads the next token.
+   * @return the token.
+   */
+  Token next();
+
+  /**
+   * Skips the rest of a value. To be called right after next() returned the
+   * first token of the value; nested objects and arrays are consumed.
+   * @param token the first token of the value.
+   * @return false if the document is not valid.
+   */
+  bool skipValue(Token token);
+
+  // The decoded Key or String. Only valid until the next call to next().
+  absl::string_view str() const { return str_; }
+  // The Number.
+  double number() const { return number_; }
+  // The Bool.
+  bool boolean() const { return boolean_; }
+  // The number of objects and arrays currently open.
+  size_t depth() const { return frames_.size(); }
+
+ private:
+  // What is expected next inside the innermost object or array.
+  enum Expect {
+    // A key or '}' in an object, a value or ']' in an array.
+    Member,
+    // ':' and a value after a key.
+    Value,
+    // ',' or the closing bracket.
+    Separator,
+  };
+
+  struct Frame {
+    bool is_object;
+    // Nesting cost of the frame, see kMaxDepth.
+    int depth;
+    Expect expect;
+  };
+
+  Token fail();
+  void skipWhitespace();
+  Token readKey();
+  Token readValue(int depth);
+  Token beginContainer(bool is_object, int depth);
+  Token endContainer();
+  bool readString();
+  bool readNumber();
+  bool readKeyword(absl::string_view keyword);
+
+  absl::string_view json_;
+  size_t pos_ = 0;
+  bool error_ = false;
+  bool done_ = false;
+  std::vector<Frame> frames_;
+  // Keys already seen in each open object, to reject duplicates.
+  std::vector<absl::flat_hash_set<std::string>> keys_;
+  // Number of entries of keys_ in use.
+  size_t open_objects_ = 0;
+
+  absl::string_view str_;
+  // Holds str_ when it contains escapes.
+  std::string str_buf_;
+  double number_ = 0;
+  bool boolean_ = false;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
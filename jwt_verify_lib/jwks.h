@@ -14,13 +14,19 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
 #include "jwt_verify_lib/status.h"
 
 #include "openssl/ec.h"
 #include "openssl/evp.h"
+#include "openssl/hmac.h"
 #include "openssl/pem.h"
 
 namespace google {
@@ -46,10 +52,71 @@ class Jwks : public WithStatus {
                                              const std::string& kid,
                                              const std::string& alg);
 
+  /**
+   * Create from a JWKS string, like createFrom with type=JWKS, reusing the
+   * keys of previous whose JWK is unchanged instead of parsing them again.
+   * previous is not modified and may be destroyed afterwards.
+   * @param previous the keyset built from an earlier version of pkey_jwks.
+   * @param pkey_jwks the JWKS string.
+   * @return the keyset, with the same keys and status as createFrom.
+   */
+  static std::unique_ptr<Jwks> updateFrom(const Jwks& previous,
+                                          const std::string& pkey_jwks);
+
+  /**
+   * Create from the output of serializeBinary(), without parsing JSON or
+   * decoding base64. The data is only read during the call, so it can be
+   * memory-mapped.
+   * @param data the binary keyset.
+   * @return the keyset, its status is not Ok if the data is malformed.
+   */
+  static std::unique_ptr<Jwks> createFromBinary(absl::string_view data);
+
+  /**
+   * Serialize the keys to a versioned binary format holding the raw key
+   * material, kid and alg, to be loaded by createFromBinary().
+   * @return the binary keyset.
+   */
+  std::string serializeBinary() const;
+
   // Adds a key to this keyset.
   Status addKeyFromPem(const std::string& pkey, const std::string& kid,
                        const std::string& alg);
 
+  // Key types, only the supported ones are distinguished.
+  enum class KeyType {
+    Unknown,
+    RSA,
+    EC,
+    Oct,
+    // OKP with the Ed25519 curve, the only supported OKP curve.
+    OKP,
+  };
+
+  // Signing algorithms.
+  enum class Algorithm {
+    // No alg specified.
+    None,
+    // An alg that is not implemented.
+    Unknown,
+    RS256,
+    RS384,
+    RS512,
+    PS256,
+    PS384,
+    PS512,
+    ES256,
+    ES384,
+    ES512,
+    HS256,
+    HS384,
+    HS512,
+    EdDSA,
+  };
+
+  // Converts an alg to Algorithm, None for an empty alg.
+  static Algorithm algorithmFromString(absl::string_view alg);
+
   // Struct for JSON Web Key
   struct Pubkey {
     std::string hmac_key_;
@@ -62,23 +129,109 @@ class Jwks : public WithStatus {
     std::string okp_key_raw_;
     bssl::UniquePtr<BIO> bio_;
     bssl::UniquePtr<X509> x509_;
+
+    // Set once when the key is loaded, to avoid string compares and
+    // allocations for each verification.
+    // kty_ and crv_ as an enum
+    KeyType key_type_ = KeyType::Unknown;
+    // alg_ as an enum
+    Algorithm algorithm_ = Algorithm::None;
+    // rsa_ or ec_key_ as an EVP_PKEY
+    bssl::UniquePtr<EVP_PKEY> evp_pkey_;
+    // The length of the signatures of ec_key_: r and s, each as long as the
+    // field elements of its curve.
+    size_t ec_signature_len_ = 0;
+    // hmac_key_ keyed for each digest, to be copied for each verification.
+    // Only the digest of alg_ is set if alg_ is specified.
+    bssl::UniquePtr<HMAC_CTX> hmac_sha256_;
+    bssl::UniquePtr<HMAC_CTX> hmac_sha384_;
+    bssl::UniquePtr<HMAC_CTX> hmac_sha512_;
+    // A digest of the JWK or X509 certificate the key was built from, empty
+    // for a PEM key. Used by updateFrom() to find the unchanged keys.
+    std::string fingerprint_;
   };
   typedef std::unique_ptr<Pubkey> PubkeyPtr;
 
   // Access to list of Jwks
   const std::vector<PubkeyPtr>& keys() const { return keys_; }
 
+  /**
+   * Get the keys that can verify a JWT with the given kid, in keyset order:
+   * the keys with the same kid and the keys without a kid. All the keys are
+   * returned for an empty kid. The lookup doesn't depend on the keyset size.
+   * @param kid the kid of the JWT.
+   * @return the candidate keys, valid until the keyset is modified.
+   */
+  const std::vector<const Pubkey*>& keysForKid(absl::string_view kid) const;
+
+  /**
+   * Get the generation of the keyset. It is unique across all the Jwks of
+   * the process and changes each time keys are added, so results computed
+   * with a keyset can be cached by generation. Changes made directly to the
+   * fields of keys() are not tracked.
+   * @return the generation.
+   */
+  uint64_t generation() const { return generation_; }
+
+  /**
+   * Get the hint set by setKeyHint() for tokens with the same issuer, kid and
+   * alg. The hints are kept in a few slots without locking, a hint may be
+   * replaced by the hint of other tokens at any time.
+   * @param iss the issuer of the JWT.
+   * @param kid the kid of the JWT.
+   * @param alg the alg of the JWT.
+   * @return an index in keysForKid(kid), or kNoKeyHint. It may be out of
+   * range if the keyset was modified directly.
+   */
+  size_t keyHint(absl::string_view iss, absl::string_view kid,
+                 absl::string_view alg) const;
+
+  /**
+   * Record the key which verified a token, to be tried first for the next
+   * tokens with the same issuer, kid and alg. It may be called concurrently
+   * on a shared keyset.
+   * @param iss the issuer of the JWT.
+   * @param kid the kid of the JWT.
+   * @param alg the alg of the JWT.
+   * @param index the index of the key in keysForKid(kid).
+   */
+  void setKeyHint(absl::string_view iss, absl::string_view kid,
+                  absl::string_view alg, size_t index) const;
+
+  static constexpr size_t kNoKeyHint = static_cast<size_t>(-1);
+
  private:
-  // Create Jwks
-  void createFromJwksCore(const std::string& pkey_jwks);
+  // Create Jwks, reusing the unchanged keys of previous if not null
+  void createFromJwksCore(const std::string& pkey_jwks,
+                          const Jwks* previous = nullptr);
   // Create PEM
   void createFromPemCore(const std::string& pkey_pem);
+  // Create from the binary format
+  void createFromBinaryCore(absl::string_view data);
+  // Set the precomputed fields of the keys and rebuild the kid index, to be
+  // called after keys_ is modified.
+  void prepareKeys();
 
   // List of Jwks
   std::vector<PubkeyPtr> keys_;
+  // All the keys
+  std::vector<const Pubkey*> all_keys_;
+  // Keys without a kid
+  std::vector<const Pubkey*> kidless_keys_;
+  // For each kid, keys with this kid or without a kid
+  absl::flat_hash_map<std::string, std::vector<const Pubkey*>> kid_index_;
+  // Set by prepareKeys()
+  uint64_t generation_ = 0;
+  // The key hints by a hash of the issuer, kid and alg. Each slot holds the
+  // high 32 bits of the hash and the index of the key plus one, 0 if empty.
+  // Cleared by prepareKeys().
+  static constexpr size_t kKeyHintSlots = 16;
+  mutable std::array<std::atomic<uint64_t>, kKeyHintSlots> key_hints_{};
 };
 
 typedef std::unique_ptr<Jwks> JwksPtr;
+// A keyset shared between threads, it must not be modified once shared.
+typedef std::shared_ptr<const Jwks> JwksSnapshot;
 
 }  // namespace jwt_verify
 }  // namespace google
@@ -0,0 +1,78 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "jwt_verify_lib/jwks.h"
+#include "jwt_verify_lib/status.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * Holds the current keyset of a process, shared by all the threads that
+ * verify tokens. Readers acquire the current snapshot without a mutex and
+ * keep using it even if a new one is published meanwhile; a snapshot is
+ * destroyed when its last reader releases it.
+ *
+ * Example:
+ *   JwksHolder holder;
+ *   holder.refresh(jwks_json);  // on the control thread
+ *   JwksSnapshot jwks = holder.acquire();  // on a worker thread
+ *   if (jwks) { Status status = verifyJwt(jwt, *jwks); }
+ */
+class JwksHolder {
+ public:
+  JwksHolder() = default;
+  explicit JwksHolder(JwksSnapshot jwks);
+
+  JwksHolder(const JwksHolder&) = delete;
+  JwksHolder& operator=(const JwksHolder&) = delete;
+
+  /**
+   * Get the current keyset.
+   * @return the current keyset, or nullptr if none was published.
+   */
+  JwksSnapshot acquire() const;
+
+  /**
+   * Replace the current keyset for all the threads. The previous keyset is
+   * kept alive by its readers.
+   * @param jwks the new keyset.
+   */
+  void publish(JwksSnapshot jwks);
+
+  /**
+   * Build a keyset from a JWKS string and publish it if it is valid, reusing
+   * the unchanged keys of the current keyset (see Jwks::updateFrom).
+   * Concurrent refreshes are serialized; readers are not blocked.
+   * @param pkey_jwks the JWKS string.
+   * @return the status of the new keyset, the current keyset is kept if it
+   * isn't Ok.
+   */
+  Status refresh(const std::string& pkey_jwks);
+
+ private:
+  // Accessed with std::atomic_load and std::atomic_store only.
+  JwksSnapshot jwks_;
+  // Serializes refresh(), so that each refresh reuses the keys of the last.
+  std::mutex refresh_mutex_;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -0,0 +1,147 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "absl/strings/string_view.h"
+#include "jwt_verify_lib/jwks.h"
+#include "jwt_verify_lib/jwks_holder.h"
+#include "jwt_verify_lib/status.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * Fetches the keyset of an issuer and refreshes it periodically on its own
+ * thread, so that the keys are never fetched or parsed on the request path.
+ * Each valid keyset is published atomically as in JwksHolder; if a fetch
+ * fails or returns an invalid keyset, the last good keyset is kept.
+ *
+ * A token with a kid missing from the keyset usually means that the keys
+ * were rotated: acquireForKid() then requests an early refresh. All the
+ * requests made before the refresh starts are served by one fetch, and
+ * early refreshes are at least min_refresh_interval apart.
+ *
+ * Example:
+ *   JwksProvider provider([](std::string* jwks) {
+ *     return httpGet(jwks_uri, jwks);
+ *   });
+ *   // On a worker thread
+ *   JwksSnapshot jwks = provider.acquireForKid(jwt.kid_);
+ *   if (jwks) { Status status = verifyJwt(jwt, *jwks); }
+ */
+class JwksProvider {
+ public:
+  /**
+   * Fetch the JWKS string of the issuer, e.g. from its jwks_uri. It is only
+   * called on the provider thread, one fetch at a time.
+   * @param pkey_jwks the output JWKS string.
+   * @return false if the keyset can't be fetched.
+   */
+  typedef std::function<bool(std::string* pkey_jwks)> Fetcher;
+
+  struct Options {
+    // The interval between two scheduled refreshes.
+    std::chrono::milliseconds refresh_interval = std::chrono::minutes(5);
+    // The minimum interval between a refresh and an early refresh, which is
+    // also the retry interval after a failed refresh.
+    std::chrono::milliseconds min_refresh_interval = std::chrono::seconds(10);
+    // Called on the provider thread after each refresh with its status:
+    // JwksFetchError if the fetch failed, or the status of the new keyset.
+    std::function<void(Status)> on_refresh;
+  };
+
+  /**
+   * Start the provider thread, which fetches the first keyset immediately.
+   * @param fetcher the function fetching the JWKS string.
+   * @param options the refresh options.
+   */
+  JwksProvider(Fetcher fetcher, Options options);
+  explicit JwksProvider(Fetcher fetcher);
+
+  // Stop the provider thread, waiting for a fetch in progress.
+  ~JwksProvider();
+
+  JwksProvider(const JwksProvider&) = delete;
+  JwksProvider& operator=(const JwksProvider&) = delete;
+
+  /**
+   * Get the current keyset, it never blocks.
+   * @return the last good keyset, or nullptr if none was fetched yet.
+   */
+  JwksSnapshot acquire() const { return holder_.acquire(); }
+
+  /**
+   * Get the current keyset, requesting an early refresh if it has no key
+   * with the kid of a token. The current keyset is returned anyway, as it
+   * may still have a key without a kid for the token.
+   * @param kid the kid of the JWT, no refresh is requested if it's empty.
+   * @return the last good keyset, or nullptr if none was fetched yet.
+   */
+  JwksSnapshot acquireForKid(absl::string_view kid);
+
+  /**
+   * Request an early refresh. It never blocks, and it is coalesced with a
+   * refresh already requested, or dropped if a refresh is in progress.
+   */
+  void requestRefresh();
+
+  /**
+   * Wait until a keyset is available, e.g. before serving requests.
+   * @param timeout the maximum time to wait.
+   * @return true if a keyset is available.
+   */
+  bool waitForKeys(std::chrono::milliseconds timeout);
+
+  // Return the status of the last refresh, or Ok if none completed yet.
+  Status lastStatus() const;
+
+ private:
+  // The provider thread.
+  void run();
+
+  // Fetch and publish a keyset, on the provider thread.
+  Status refresh();
+
+  const Fetcher fetcher_;
+  const Options options_;
+  JwksHolder holder_;
+  // The last fetched JWKS string, to skip parsing an unchanged keyset.
+  std::string last_jwks_;
+
+  mutable std::mutex mutex_;
+  // Notified on requestRefresh() and on destruction.
+  std::condition_variable wakeup_;
+  // Notified when a keyset is published.
+  std::condition_variable published_;
+  // Fields guarded by mutex_.
+  bool stopping_ = false;
+  bool refresh_requested_ = false;
+  bool refreshing_ = false;
+  Status last_status_ = Status::Ok;
+  std::chrono::steady_clock::time_point last_refresh_;
+
+  // Declared last, so that it starts after the other fields are initialized.
+  std::thread thread_;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -0,0 +1,116 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "jwt_verify_lib/jwks.h"
+#include "jwt_verify_lib/status.h"
+#include "simple_lru_cache/sharded_simple_lru_cache.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * Holds the keysets of many issuers in one file, in the binary format of
+ * Jwks::serializeBinary(). The file is memory-mapped, and the keys of an
+ * issuer are only created the first time they are requested. The most
+ * recently used keysets are kept, the others are only in the mapping.
+ *
+ * It is thread safe.
+ *
+ * Example:
+ *   // Offline
+ *   std::string data = JwksStore::serialize({{issuer, jwks.get()}, ...});
+ *   // On the proxy
+ *   auto store = JwksStore::createFromFile(path, 1000);
+ *   if (store->getStatus() == Status::Ok) {
+ *     JwksSnapshot jwks = store->get(jwt.iss_);
+ *   }
+ */
+class JwksStore : public WithStatus {
+ public:
+  /**
+   * Serialize keysets to the store format.
+   * @param keysets the keyset of each issuer.
+   * @return the content of a store file.
+   */
+  static std::string serialize(
+      const std::map<std::string, const Jwks*>& keysets);
+
+  /**
+   * Map a store file.
+   * @param path the path of a file written with the output of serialize().
+   * @param max_cached_issuers the maximum number of keysets to keep created.
+   * @return the store, its status is not Ok if the file can't be mapped or
+   * is malformed.
+   */
+  static std::unique_ptr<JwksStore> createFromFile(const std::string& path,
+                                                   size_t max_cached_issuers);
+
+  /**
+   * Create a store from data already in memory.
+   * @param data the output of serialize(), it must outlive the store.
+   * @param max_cached_issuers the maximum number of keysets to keep created.
+   * @return the store, its status is not Ok if the data is malformed.
+   */
+  static std::unique_ptr<JwksStore> createFromData(absl::string_view data,
+                                                   size_t max_cached_issuers);
+
+  ~JwksStore();
+
+  JwksStore(const JwksStore&) = delete;
+  JwksStore& operator=(const JwksStore&) = delete;
+
+  /**
+   * Get the keyset of an issuer, creating its keys if they aren't cached.
+   * @param issuer the issuer.
+   * @return the keyset, or nullptr if the issuer is unknown or its keyset is
+   * malformed.
+   */
+  JwksSnapshot get(absl::string_view issuer);
+
+  // Return the number of issuers in the store.
+  size_t issuers() const { return index_.size(); }
+
+  // Return the number of keysets currently created.
+  size_t cachedIssuers() const { return cache_.entries(); }
+
+ private:
+  explicit JwksStore(size_t max_cached_issuers);
+
+  // Parse the index of data_.
+  void createIndex();
+
+  struct Entry {
+    JwksSnapshot jwks;
+  };
+
+  // The store content, either mapped or owned by the caller.
+  absl::string_view data_;
+  // The mapping of the file, if created from a file.
+  void* mapping_ = nullptr;
+  size_t mapping_length_ = 0;
+  // The binary keyset of each issuer, pointing into data_.
+  absl::flat_hash_map<absl::string_view, absl::string_view> index_;
+  simple_lru_cache::ShardedSimpleLRUCache<std::string, Entry> cache_;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
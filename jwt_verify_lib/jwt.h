@@ -14,9 +14,12 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "absl/strings/string_view.h"
+#include "google/protobuf/arena.h"
 #include "google/protobuf/struct.pb.h"
 
 #include "jwt_verify_lib/status.h"
@@ -27,6 +30,21 @@ namespace jwt_verify {
 // Clock skew defaults to one minute.
 constexpr uint64_t kClockSkewInSecond = 60;
 
+/**
+ * A Struct protobuf built on first access. The copies share the Struct, which
+ * is immutable once built.
+ */
+struct SharedStruct {
+  SharedStruct() {}
+  SharedStruct(const SharedStruct& other);
+  SharedStruct& operator=(const SharedStruct& other);
+  // Moving from a SharedStruct must not race with its first access.
+  SharedStruct(SharedStruct&& other) noexcept = default;
+  SharedStruct& operator=(SharedStruct&& other) noexcept = default;
+
+  mutable std::shared_ptr<const ::google::protobuf::Struct> pb;
+};
+
 /**
  * struct to hold a JWT data.
  */
@@ -34,19 +52,13 @@ struct Jwt {
   // entire jwt
   std::string jwt_;
 
-  // header string
-  std::string header_str_;
   // header base64_url encoded
   std::string header_str_base64url_;
-  // header in Struct protobuf
-  ::google::protobuf::Struct header_pb_;
 
   // payload string
   std::string payload_str_;
   // payload base64_url encoded
   std::string payload_str_base64url_;
-  // payload in Struct protobuf
-  ::google::protobuf::Struct payload_pb_;
   // signature string
   std::string signature_;
   // alg
@@ -67,6 +79,10 @@ struct Jwt {
   uint64_t exp_ = 0;
   // JWT ID
   std::string jti_;
+  // offset and length of the signed data, header and payload base64_url
+  // encoded, inside jwt_
+  size_t signed_data_offset_ = 0;
+  size_t signed_data_len_ = 0;
 
   /**
    * Standard constructor.
@@ -74,18 +90,27 @@ struct Jwt {
   Jwt() {}
   /**
    * Copy constructor. The copy constructor is marked as explicit as the caller
-   * should understand the copy operation is non-trivial as a complete
-   * re-deserialization occurs.
+   * should understand the copy operation is non-trivial as the strings are
+   * copied. The token is not parsed again, and the Structs already built are
+   * shared with the copy.
    * @param rhs the instance to copy.
    */
-  explicit Jwt(const Jwt& instance);
+  explicit Jwt(const Jwt& instance) = default;
 
   /**
-   * Copy Jwt instance.
+   * Copy Jwt instance, see the copy constructor.
    * @param rhs the instance to copy.
    * @return this
    */
-  Jwt& operator=(const Jwt& rhs);
+  Jwt& operator=(const Jwt& rhs) = default;
+
+  /**
+   * Move constructor and assignment, the strings and the Structs are moved,
+   * rhs is left in a valid but unspecified state.
+   * @param rhs the instance to move from.
+   */
+  Jwt(Jwt&& rhs) noexcept = default;
+  Jwt& operator=(Jwt&& rhs) noexcept = default;
 
   /**
    * Parse Jwt from string text
@@ -93,6 +118,154 @@ struct Jwt {
    */
   Status parseFromString(const std::string& jwt);
 
+  /**
+   * Parse Jwt from string text. The Structs returned by headerPb() and
+   * payloadPb() are allocated on arena, so that they are freed at once with
+   * the arena, which must outlive this Jwt and its copies.
+   * @param arena the arena of the Structs, the heap if nullptr.
+   * @return the status.
+   */
+  Status parseFromString(const std::string& jwt,
+                         ::google::protobuf::Arena* arena);
+
+  /**
+   * Get the header in Struct protobuf. It is built on first access and then
+   * cached until the next parseFromString.
+   * @return the header, only meaningful after a successful parseFromString.
+   */
+  const ::google::protobuf::Struct& headerPb() const;
+
+  /**
+   * Get the payload in Struct protobuf. It is built on first access and then
+   * cached until the next parseFromString.
+   * @return the payload, only meaningful after a successful parseFromString.
+   */
+  const ::google::protobuf::Struct& payloadPb() const;
+
+  /**
+   * Get the signed data, i.e. the input of the signature, as a view into jwt_.
+   * It is only valid while jwt_ is not modified.
+   * @return the header and payload base64_url encoded, separated by a dot.
+   */
+  absl::string_view signedData() const;
+
+  /*
+   * Verify Jwt time constraint if specified
+   * esp: expiration time, nbf: not before time.
+   * @param now: is the current time in seconds since the unix epoch
+   * @param clock_skew: the the clock skew in second.
+   * @return the verification status.
+   */
+  Status verifyTimeConstraint(uint64_t now,
+                              uint64_t clock_skew = kClockSkewInSecond) const;
+
+ private:
+  // header and payload in Struct protobuf, built on first access
+  SharedStruct header_pb_;
+  SharedStruct payload_pb_;
+  // The arena of header_pb_ and payload_pb_, or nullptr.
+  ::google::protobuf::Arena* arena_ = nullptr;
+};
+
+// A parsed token shared between threads or processing stages without a copy,
+// it must not be modified once shared.
+typedef std::shared_ptr<const Jwt> SharedJwt;
+
+/**
+ * struct to hold a JWT parsed in place from a buffer owned by the caller.
+ * Unlike Jwt, the token is not copied: the three base64_url segments and the
+ * signed data are views into the caller's buffer, which must outlive this
+ * object. The header JSON is not kept and the Struct protobufs are only built
+ * on demand.
+ */
+struct JwtView {
+  // entire jwt
+  absl::string_view jwt_;
+  // header base64_url encoded
+  absl::string_view header_str_base64url_;
+  // payload base64_url encoded
+  absl::string_view payload_str_base64url_;
+  // signature base64_url encoded
+  absl::string_view signature_str_base64url_;
+  // header and payload base64_url encoded, the input of the signature
+  absl::string_view signed_data_;
+
+  // payload string
+  std::string payload_str_;
+  // signature string
+  std::string signature_;
+  // alg
+  std::string alg_;
+  // kid
+  std::string kid_;
+  // iss
+  std::string iss_;
+  // audiences
+  std::vector<std::string> audiences_;
+  // sub
+  std::string sub_;
+  // issued at
+  uint64_t iat_ = 0;
+  // not before
+  uint64_t nbf_ = 0;
+  // expiration
+  uint64_t exp_ = 0;
+  // JWT ID
+  std::string jti_;
+
+  /**
+   * Parse Jwt from a buffer that must outlive this object. The claims are
+   * read in a single pass over the JSON, without building a Struct.
+   * @return the status.
+   */
+  Status parseFromString(absl::string_view jwt);
+
+  /**
+   * Parse Jwt from a buffer that must outlive this object, with the Structs
+   * allocated on arena, which must outlive this object too.
+   * @param arena the arena of the Structs, the heap if nullptr.
+   * @return the status.
+   */
+  Status parseFromString(absl::string_view jwt,
+                         ::google::protobuf::Arena* arena);
+
+  /**
+   * Same as parseFromString, except that the signature is not decoded and
+   * signature_ is left empty, so that the claims can be checked before any
+   * work is spent on the signature.
+   * @return the status.
+   */
+  Status parseClaimsFromString(absl::string_view jwt);
+
+  /**
+   * Same as parseFromString, for a caller accepting a single alg. A token
+   * with another alg fails with JwksKidAlgMismatch right after the header is
+   * scanned, before the payload is decoded.
+   * @param alg the accepted alg, which must be implemented.
+   * @return the status.
+   */
+  Status parseFromStringForAlg(absl::string_view jwt, absl::string_view alg);
+
+  /**
+   * Decode the signature after parseClaimsFromString.
+   * @return the status, JwtSignatureParseErrorBadBase64 on a bad signature.
+   */
+  Status decodeSignature();
+
+  /**
+   * Get the header in Struct protobuf. It is built on first access and then
+   * cached until the next parseFromString.
+   * @return the header, only meaningful after a successful parseFromString.
+   */
+  const ::google::protobuf::Struct& headerPb() const;
+
+  /**
+   * Get the payload in Struct protobuf. It is built on first access and then
+   * cached until the next parseFromString.
+   * @return the payload, only meaningful after a successful parseFromString.
+   */
+  const ::google::protobuf::Struct& payloadPb() const;
+
   /*
    * Verify Jwt time constraint if specified
    * esp: expiration time, nbf: not before time.
@@ -102,6 +275,16 @@ struct Jwt {
    */
   Status verifyTimeConstraint(uint64_t now,
                               uint64_t clock_skew = kClockSkewInSecond) const;
+
+ private:
+  Status parse(absl::string_view jwt, bool decode_signature,
+               absl::string_view alg = absl::string_view());
+
+  // header and payload in Struct protobuf, built on first access
+  SharedStruct header_pb_;
+  SharedStruct payload_pb_;
+  // The arena of header_pb_ and payload_pb_, or nullptr.
+  ::google::protobuf::Arena* arena_ = nullptr;
 };
 
 }  // namespace jwt_verify
@@ -0,0 +1,169 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "jwt_verify_lib/check_audience.h"
+#include "jwt_verify_lib/jwks.h"
+#include "jwt_verify_lib/jwt.h"
+#include "jwt_verify_lib/status.h"
+#include "simple_lru_cache/sharded_simple_lru_cache.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * Caches the tokens that passed signature verification, so that a token sent
+ * again is neither parsed nor verified again. On a hit only the audiences and
+ * the time constraints are checked.
+ *
+ * Entries are keyed by a hash of the token and the Jwks generation, so a new
+ * or modified keyset never reuses a verdict of another one. The token itself
+ * is kept and compared on a hit, so hash collisions can't be exploited.
+ *
+ * An entry is never used after its token expired. It is removed by the
+ * first lookup after its exp, by the next insertion into its shard, which
+ * sweeps the expired entries of the shard at most once per second of the
+ * callers' clock, or by removeExpiredEntries(). The entries of tokens
+ * without an exp are removed once unused for the max idle time.
+ *
+ * The tokens whose signature failed verification are remembered too, so
+ * that a replayed forged token isn't verified again, and so are the kid and
+ * alg pairs that match no key of a keyset. They are kept apart from the
+ * valid tokens, in another cache of max_entries, so that they can't evict
+ * them. The checks that don't depend on the signature are still done for a
+ * rejected token, the status is the same as without the cache.
+ *
+ * It is thread safe. The entries are split in shards locked independently,
+ * so concurrent lookups of different tokens rarely contend.
+ *
+ * Example:
+ *   JwtVerificationCache cache(10000);
+ *   Status status = cache.verify(token, *jwks, audiences, now);
+ */
+class JwtVerificationCache {
+ public:
+  /**
+   * Creates a cache.
+   * @param max_entries the maximum number of tokens to keep.
+   * @param num_shards the number of shards, at most max_entries are used.
+   */
+  explicit JwtVerificationCache(size_t max_entries, size_t num_shards = 16);
+
+  // The default max idle time of the entries, in seconds.
+  static constexpr double kDefaultMaxIdleSeconds = 300;
+
+  /**
+   * Parses and verifies a token, the same as Jwt::parseFromString followed by
+   * verifyJwt(jwt, jwks, audiences, now), with the given clock skew.
+   * @param token the token.
+   * @param jwks the keyset.
+   * @param audiences the allowed audiences, none are checked if empty.
+   * @param now the number of seconds since the unix epoch.
+   * @param clock_skew the clock skew in second.
+   * @param jwt if not nullptr, set to the parsed token on Status::Ok.
+   * @return the verification status.
+   */
+  Status verify(absl::string_view token, const Jwks& jwks,
+                const std::vector<std::string>& audiences, uint64_t now,
+                uint64_t clock_skew = kClockSkewInSecond,
+                SharedJwt* jwt = nullptr);
+
+  /**
+   * Same as verify(token, jwks, audiences, now, clock_skew, jwt) with the
+   * audiences already built, so that a CheckAudience built once from the
+   * config is used for every token instead of one per call.
+   * @param audiences the allowed audiences, none are checked if empty.
+   */
+  Status verify(absl::string_view token, const Jwks& jwks,
+                const CheckAudience& audiences, uint64_t now,
+                uint64_t clock_skew = kClockSkewInSecond,
+                SharedJwt* jwt = nullptr);
+
+  /**
+   * Removes the entries of the expired tokens and the idle entries, e.g.
+   * from a periodic timer of a host with few distinct tokens.
+   * @param now the number of seconds since the unix epoch.
+   */
+  void removeExpiredEntries(uint64_t now);
+
+  /**
+   * Sets the time after which an unused entry is removed, even if its token
+   * didn't expire, which bounds the lifetime of tokens without an exp.
+   * @param seconds the max idle time, entries never idle out if negative.
+   */
+  void setMaxIdleSeconds(double seconds);
+
+  // Return the number of tokens in the cache.
+  size_t entries() const;
+
+  // Return the number of rejected tokens and kid and alg pairs in the cache.
+  size_t rejectedEntries() const;
+
+ private:
+  struct Key {
+    size_t token_hash;
+    uint64_t jwks_generation;
+
+    bool operator==(const Key& other) const {
+      return token_hash == other.token_hash &&
+             jwks_generation == other.jwks_generation;
+    }
+    template <typename H>
+    friend H AbslHashValue(H h, const Key& key) {
+      return H::combine(std::move(h), key.token_hash, key.jwks_generation);
+    }
+  };
+
+  struct Entry {
+    SharedJwt jwt;
+    // The exp of the token plus the clock skew, 0 if it has no exp.
+    uint64_t expires_at;
+  };
+
+  // A token that failed signature verification, or a kid and alg pair if jwt
+  // is nullptr, keyed by a hash of the pair.
+  struct Rejection {
+    SharedJwt jwt;
+    std::string kid;
+    std::string alg;
+    Status status;
+    // As for Entry, 0 for a kid and alg pair.
+    uint64_t expires_at;
+  };
+
+  // Get the cached token, nullptr on a miss.
+  SharedJwt lookup(const Key& key, absl::string_view token, uint64_t now,
+                   uint64_t clock_skew);
+
+  // Get the rejected token and its status, nullptr on a miss.
+  SharedJwt lookupRejected(const Key& key, absl::string_view token,
+                           Status* status);
+
+  // Return true if the kid and alg pair of key is rejected.
+  bool isKidAlgRejected(const Key& key, absl::string_view kid,
+                        absl::string_view alg);
+
+  simple_lru_cache::ShardedSimpleLRUCache<Key, Entry, absl::Hash<Key>> cache_;
+  simple_lru_cache::ShardedSimpleLRUCache<Key, Rejection, absl::Hash<Key>>
+      rejected_;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
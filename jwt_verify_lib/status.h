@@ -219,6 +219,16 @@ enum class Status {
 
   // Failed to create BIO
   JwksBioAllocError,
+
+  // Binary keyset is truncated or malformed
+  JwksBinaryParseError,
+  // Binary keyset has an unsupported format version
+  JwksBinaryBadVersion,
+  // Keystore file can't be opened or mapped
+  JwksStoreOpenError,
+
+  // Jwks can't be fetched by a JwksProvider
+  JwksFetchError,
 };
 
 /**
@@ -14,9 +14,17 @@
 
 #pragma once
 
+#include <functional>
+#include <string>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "jwt_verify_lib/check_audience.h"
 #include "jwt_verify_lib/jwks.h"
 #include "jwt_verify_lib/jwt.h"
 #include "jwt_verify_lib/status.h"
+#include "jwt_verify_lib/verify_context.h"
 
 namespace google {
 namespace jwt_verify {
@@ -31,6 +39,39 @@ namespace jwt_verify {
  */
 Status verifyJwtWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks);
 
+/**
+ * This function verifies JWT signature is valid. The signed data is hashed in
+ * place, directly from the buffer the JwtView was parsed from.
+ * If verification failed, returns the failure reason.
+ * Note this method does not verify the "aud" claim.
+ * @param jwt is JwtView object
+ * @param jwks is Jwks object
+ * @return the verification status
+ */
+Status verifyJwtWithoutTimeChecking(const JwtView& jwt, const Jwks& jwks);
+
+/**
+ * The same as verifyJwtWithoutTimeChecking(jwt, jwks), reusing the BoringSSL
+ * objects held by context.
+ * @param jwt is Jwt object
+ * @param jwks is Jwks object
+ * @param context is used for this verification only, see VerifyContext
+ * @return the verification status
+ */
+Status verifyJwtWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks,
+                                    VerifyContext& context);
+
+/**
+ * The same as verifyJwtWithoutTimeChecking(jwt, jwks), reusing the BoringSSL
+ * objects held by context.
+ * @param jwt is JwtView object
+ * @param jwks is Jwks object
+ * @param context is used for this verification only, see VerifyContext
+ * @return the verification status
+ */
+Status verifyJwtWithoutTimeChecking(const JwtView& jwt, const Jwks& jwks,
+                                    VerifyContext& context);
+
 /**
  * This function verifies JWT signature is valid and that it has not expired
  * checking the "exp" and "nbf" claims against the system's current wall clock.
@@ -56,6 +97,75 @@ Status verifyJwt(const Jwt& jwt, const Jwks& jwks);
 Status verifyJwt(const Jwt& jwt, const Jwks& jwks, uint64_t now,
                  uint64_t clock_skew = kClockSkewInSecond);
 
+/**
+ * This function verifies JWT signature is valid and that it has not expired
+ * checking the "exp" and "nbf" claims against the provided time. If
+ * verification failed, returns the failure reason. Note this method does not
+ * verify the "aud" claim.
+ * @param jwt is JwtView object
+ * @param jwks is Jwks object
+ * @param now is the number of seconds since the unix epoch
+ * @param clock_skew is the clock skew in second
+ * @return the verification status
+ */
+Status verifyJwt(const JwtView& jwt, const Jwks& jwks, uint64_t now,
+                 uint64_t clock_skew = kClockSkewInSecond);
+
+/**
+ * The same as verifyJwt(jwt, jwks, now, clock_skew), reusing the BoringSSL
+ * objects held by context.
+ * @param jwt is Jwt object
+ * @param jwks is Jwks object
+ * @param now is the number of seconds since the unix epoch
+ * @param clock_skew is the clock skew in second
+ * @param context is used for this verification only, see VerifyContext
+ * @return the verification status
+ */
+Status verifyJwt(const Jwt& jwt, const Jwks& jwks, uint64_t now,
+                 uint64_t clock_skew, VerifyContext& context);
+
+/**
+ * The same as verifyJwt(jwt, jwks, now, clock_skew), reusing the BoringSSL
+ * objects held by context.
+ * @param jwt is JwtView object
+ * @param jwks is Jwks object
+ * @param now is the number of seconds since the unix epoch
+ * @param clock_skew is the clock skew in second
+ * @param context is used for this verification only, see VerifyContext
+ * @return the verification status
+ */
+Status verifyJwt(const JwtView& jwt, const Jwks& jwks, uint64_t now,
+                 uint64_t clock_skew, VerifyContext& context);
+
+/**
+ * Runs a task, possibly on another thread. The task may also be run before
+ * the executor returns.
+ */
+typedef std::function<void(std::function<void()>)> Executor;
+
+/**
+ * This function verifies many JWTs against the same keyset: out[i] is set to
+ * verifyJwt(*jwts[i], jwks, now, clock_skew). The tokens with the same kid and
+ * alg are verified together so that their keys and digests are resolved once,
+ * and these groups can be spread across an executor. It returns once all the
+ * tokens are verified.
+ * Note this method does not verify the "aud" claim.
+ * @param jwts are the Jwt objects, none can be nullptr
+ * @param jwks is Jwks object
+ * @param now is the number of seconds since the unix epoch
+ * @param out receives the verification status of each token, it must have
+ * the size of jwts
+ * @param executor runs the verifications, they run on the calling thread if
+ * it is empty. The calling thread verifies tokens too and only waits for the
+ * tasks already started, so the executor may be a pool the calling thread
+ * belongs to, and it may drop tasks.
+ * @param clock_skew is the clock skew in second
+ */
+void verifyJwtBatch(absl::Span<const Jwt* const> jwts, const Jwks& jwks,
+                    uint64_t now, absl::Span<Status> out,
+                    const Executor& executor = nullptr,
+                    uint64_t clock_skew = kClockSkewInSecond);
+
 /**
  * This function verifies JWT signature is valid, that it has not expired
  * checking the "exp" and "nbf" claims against the system's current wall clock
@@ -88,5 +198,228 @@ Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
 Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
                  const std::vector<std::string>& audiences, uint64_t now);
 
+/**
+ * Same as verifyJwt(jwt, jwks, audiences) with audiences already built, so
+ * that a CheckAudience built once from the config can be used for every
+ * token.
+ * @param jwt is Jwt object
+ * @param jwks is Jwks object
+ * @param audiences the audiences by which to check against.
+ * @return the verification status
+ */
+Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
+                 const CheckAudience& audiences);
+
+/**
+ * Same as verifyJwt(jwt, jwks, audiences, now) with audiences already built.
+ * @param jwt is Jwt object
+ * @param jwks is Jwks object
+ * @param audiences the audiences by which to check against.
+ * @param now is the number of seconds since the unix epoch
+ * @return the verification status
+ */
+Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
+                 const CheckAudience& audiences, uint64_t now);
+
+/**
+ * Verifies tokens in stages ordered by cost, so that tokens failing a cheap
+ * check don't cost any signature work:
+ *   1. the header and the payload are decoded, but not the signature;
+ *   2. "nbf" and "exp" against now;
+ *   3. "iss" against the allowed issuers;
+ *   4. "aud" against the allowed audiences;
+ *   5. the additional claims check of the options;
+ *   6. a key of the Jwks matching "kid" and "alg" must exist;
+ *   7. the signature is decoded and verified.
+ * The checks are those of verifyJwt, but a token failing several of them
+ * gets the status of the first stage it fails.
+ *
+ * It is immutable once built and can be shared between threads.
+ *
+ * Example:
+ *   StagedVerifier::Options options;
+ *   options.issuers = {"https://example.com"};
+ *   options.audiences = {"example_service"};
+ *   StagedVerifier verifier(options);
+ *   JwtView jwt;
+ *   Status status = verifier.verify(token, *jwks, now, &jwt);
+ */
+class StagedVerifier {
+ public:
+  struct Options {
+    // The allowed issuers, any issuer is allowed if empty.
+    std::vector<std::string> issuers;
+    // The allowed audiences, any audience is allowed if empty.
+    std::vector<std::string> audiences;
+    // The clock skew in second.
+    uint64_t clock_skew = kClockSkewInSecond;
+    // An additional check of the claims, done before the signature is
+    // decoded. Not called if empty.
+    std::function<Status(const JwtView&)> claims_check;
+  };
+
+  explicit StagedVerifier(const Options& options);
+
+  /**
+   * Verify a token.
+   * @param token the token, it must outlive jwt.
+   * @param jwks the keyset.
+   * @param now the number of seconds since the unix epoch.
+   * @param jwt the parsed token. The signature is only decoded if the checks
+   * before the signature passed.
+   * @param context the objects reused between verifications.
+   * @return the status of the first stage failed, or Ok.
+   */
+  Status verify(absl::string_view token, const Jwks& jwks, uint64_t now,
+                JwtView* jwt, VerifyContext& context) const;
+
+  // Same as above, with a new VerifyContext.
+  Status verify(absl::string_view token, const Jwks& jwks, uint64_t now,
+                JwtView* jwt) const;
+
+ private:
+  const absl::flat_hash_set<std::string> issuers_;
+  const CheckAudience audiences_;
+  const uint64_t clock_skew_;
+  const std::function<Status(const JwtView&)> claims_check_;
+};
+
+/**
+ * Verifies tokens matching many keys, such as the tokens without kid of an
+ * issuer publishing many keys without kid, by spreading the candidate keys
+ * across an executor. The key of the Jwks::keyHint() is tried first on the
+ * calling thread, the other keys are only tried if it fails. The calling
+ * thread tries keys too, and once a key verified the token the keys after it
+ * are skipped, so it returns after about one signature verification, but it
+ * always waits for the keys already taken by a task. The tasks not started by
+ * then take no key, so an executor running its tasks on the calling thread,
+ * or on a pool the calling thread belongs to, doesn't deadlock.
+ * The status is the same as verifyJwtWithoutTimeChecking(jwt, jwks), the one
+ * of the first key in order not failing with JwtVerificationFail, whichever
+ * task finishes first.
+ *
+ * It is thread-safe. The key verifying a token is recorded with
+ * Jwks::setKeyHint(), as verifyJwt does.
+ *
+ * Example:
+ *   ParallelVerifier verifier([&pool](std::function<void()> task) {
+ *     pool.Schedule(std::move(task));
+ *   });
+ *   Status status = verifier.verifyWithoutTimeChecking(jwt, *jwks);
+ */
+class ParallelVerifier {
+ public:
+  /**
+   * @param executor runs the verifications with each key, they run on the
+   * calling thread if it is empty.
+   * @param min_parallel_keys the tokens with fewer candidate keys are
+   * verified on the calling thread.
+   */
+  explicit ParallelVerifier(Executor executor, size_t min_parallel_keys = 4);
+
+  /**
+   * Verify the signature of a token.
+   * @param jwt is Jwt object
+   * @param jwks is Jwks object
+   * @param context is used on the calling thread, see VerifyContext
+   * @return the verification status
+   */
+  Status verifyWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks,
+                                   VerifyContext& context);
+
+  // Same as above, with a new VerifyContext.
+  Status verifyWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks);
+
+  /**
+   * Verify the signature of a token and its "exp" and "nbf" claims, as
+   * verifyJwt(jwt, jwks, now, clock_skew).
+   * @param jwt is Jwt object
+   * @param jwks is Jwks object
+   * @param now is the number of seconds since the unix epoch
+   * @param clock_skew is the clock skew in second
+   * @return the verification status
+   */
+  Status verify(const Jwt& jwt, const Jwks& jwks, uint64_t now,
+                uint64_t clock_skew = kClockSkewInSecond);
+
+ private:
+  // Same as verifyWithoutTimeChecking, incrementing keys_tried for each key
+  // tried.
+  Status verifyWithKeys(const Jwt& jwt, const Jwks& jwks,
+                        VerifyContext& context, size_t* keys_tried);
+
+  const Executor executor_;
+  const size_t min_parallel_keys_;
+};
+
+/**
+ * Verifies tokens of a single alg, for deployments accepting only one. The
+ * alg and its digest are compile time constants, so that only its crypto path
+ * is compiled and a token of another alg fails with JwksKidAlgMismatch right
+ * after its header is scanned:
+ *
+ *   const Verifier<Jwks::Algorithm::ES256> verifier;
+ *   JwtView jwt;
+ *   Status status = verifier.verify(token, jwks, now, &jwt);
+ *
+ * The results are the same as verifyJwt for tokens of the alg, except that
+ * keys of another type are not tried. It is instantiated for each alg in
+ * verify.cc, None and Unknown can't be used.
+ */
+template <Jwks::Algorithm Alg>
+class Verifier {
+  static_assert(Alg != Jwks::Algorithm::None &&
+                    Alg != Jwks::Algorithm::Unknown,
+                "Verifier needs an implemented alg");
+
+ public:
+  explicit Verifier(uint64_t clock_skew = kClockSkewInSecond);
+
+  /**
+   * Parses a token into jwt and verifies it, the time checked against now.
+   * The token must outlive jwt.
+   * @param token the token.
+   * @param jwks the keyset.
+   * @param now the number of seconds since the unix epoch.
+   * @param jwt set to the parsed token.
+   * @return the verification status.
+   */
+  Status verify(absl::string_view token, const Jwks& jwks, uint64_t now,
+                JwtView* jwt) const;
+
+  // Same as above, reusing the BoringSSL objects held by context.
+  Status verify(absl::string_view token, const Jwks& jwks, uint64_t now,
+                JwtView* jwt, VerifyContext& context) const;
+
+  /**
+   * Same as verifyJwtWithoutTimeChecking for a token of the alg.
+   * @param jwt the parsed token.
+   * @param jwks the keyset.
+   * @return the verification status.
+   */
+  Status verifyWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks) const;
+
+  // Same as above, reusing the BoringSSL objects held by context.
+  Status verifyWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks,
+                                   VerifyContext& context) const;
+
+ private:
+  const uint64_t clock_skew_;
+};
+
+extern template class Verifier<Jwks::Algorithm::RS256>;
+extern template class Verifier<Jwks::Algorithm::RS384>;
+extern template class Verifier<Jwks::Algorithm::RS512>;
+extern template class Verifier<Jwks::Algorithm::PS256>;
+extern template class Verifier<Jwks::Algorithm::PS384>;
+extern template class Verifier<Jwks::Algorithm::PS512>;
+extern template class Verifier<Jwks::Algorithm::ES256>;
+extern template class Verifier<Jwks::Algorithm::ES384>;
+extern template class Verifier<Jwks::Algorithm::ES512>;
+extern template class Verifier<Jwks::Algorithm::HS256>;
+extern template class Verifier<Jwks::Algorithm::HS384>;
+extern template class Verifier<Jwks::Algorithm::HS512>;
+extern template class Verifier<Jwks::Algorithm::EdDSA>;
+
 }  // namespace jwt_verify
 }  // namespace google
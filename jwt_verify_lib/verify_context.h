@@ -0,0 +1,67 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "openssl/ecdsa.h"
+#include "openssl/evp.h"
+#include "openssl/hmac.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * Holds the BoringSSL objects used to verify a signature so that they can be
+ * reused across verifications instead of being allocated for each one.
+ * A VerifyContext is not thread safe, a typical use is one per thread:
+ *
+ *   thread_local VerifyContext context;
+ *   Status status = verifyJwt(jwt, jwks, now, clock_skew, context);
+ *
+ * The objects are created on first use, so an unused part costs nothing.
+ */
+class VerifyContext {
+ public:
+  VerifyContext() = default;
+  VerifyContext(const VerifyContext&) = delete;
+  VerifyContext& operator=(const VerifyContext&) = delete;
+
+  /**
+   * Gets a digest context in its freshly initialized state.
+   * @return the context, or nullptr if it could not be allocated.
+   */
+  EVP_MD_CTX* mdCtx();
+
+  /**
+   * Gets an ECDSA signature, its r and s are to be overwritten by the caller.
+   * @return the signature, or nullptr if it could not be allocated.
+   */
+  ECDSA_SIG* ecdsaSig();
+
+  /**
+   * Gets an HMAC context in the state of key_template, a context keyed by
+   * HMAC_Init_ex, ready to hash a message.
+   * @param key_template the keyed context.
+   * @return the context, or nullptr on failure.
+   */
+  HMAC_CTX* hmacCtx(const HMAC_CTX* key_template);
+
+ private:
+  bssl::UniquePtr<EVP_MD_CTX> md_ctx_;
+  bssl::UniquePtr<ECDSA_SIG> ecdsa_sig_;
+  bssl::UniquePtr<HMAC_CTX> hmac_ctx_;
+};
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -0,0 +1,177 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "jwt_verify_lib/status.h"
+
+namespace google {
+namespace jwt_verify {
+
+/**
+ * Receives the events of the hot path of parsing and verifying tokens, for a
+ * host to export as metrics. It is installed for the whole library with
+ * setVerifyStats(), without one each event costs a null pointer check.
+ *
+ * The methods are called concurrently by the verifying threads, they must be
+ * thread safe and cheap. They do nothing by default.
+ */
+class VerifyStats {
+ public:
+  // The stages of parsing and verifying a token.
+  enum class Stage {
+    // Decoding a base64url section: the header, payload or signature.
+    Base64Decode,
+    // Scanning the header or payload JSON for the claims.
+    JsonParse,
+    // Finding the keys matching the kid and alg of the token.
+    KeyLookup,
+    // Verifying the signature with one key.
+    Signature,
+  };
+  static constexpr size_t kNumStages = 4;
+
+  virtual ~VerifyStats() = default;
+
+  /**
+   * Called when a step of a stage is done. A stage may have several steps
+   * for one token, such as decoding its three sections or trying two keys.
+   * @param stage the stage.
+   * @param duration the time spent in the step.
+   */
+  virtual void onStage(Stage /*stage*/,
+                       std::chrono::nanoseconds /*duration*/) {}
+
+  /**
+   * Called once per token whose signature was checked.
+   * @param keys the number of keys its signature was verified with.
+   */
+  virtual void onKeysTried(size_t /*keys*/) {}
+
+  /**
+   * Called for each token looked up in a JwtVerificationCache.
+   * @param hit true if the token was verified or rejected before.
+   */
+  virtual void onCacheLookup(bool /*hit*/) {}
+
+  /**
+   * Called when parsing or verifying a token fails. A JwtVerificationCache
+   * also reports the failures it finds itself, such as a cached rejection,
+   * so that each failed call is reported once.
+   * @param status the failure.
+   */
+  virtual void onFailure(Status /*status*/) {}
+};
+
+/**
+ * Installs stats for all the parsing and verification that follow. It is
+ * meant to be called at startup, stats must stay valid until it is replaced.
+ * @param stats the stats, or nullptr to stop reporting.
+ */
+void setVerifyStats(VerifyStats* stats);
+
+namespace stats_internal {
+extern std::atomic<VerifyStats*> verify_stats;
+}  // namespace stats_internal
+
+// Returns the installed stats, or nullptr.
+inline VerifyStats* verifyStats() {
+  return stats_internal::verify_stats.load(std::memory_order_acquire);
+}
+
+// Reports status to stats unless it is Ok or stats is nullptr. Returns status.
+inline Status reportFailure(VerifyStats* stats, Status status) {
+  if (stats != nullptr && status != Status::Ok) {
+    stats->onFailure(status);
+  }
+  return status;
+}
+
+/**
+ * Reports a step of a stage from its construction to its destruction. The
+ * clock is only read if stats is not nullptr.
+ */
+class StageTimer {
+ public:
+  StageTimer(VerifyStats* stats, VerifyStats::Stage stage)
+      : stats_(stats), stage_(stage) {
+    if (stats_ != nullptr) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+  ~StageTimer() {
+    if (stats_ != nullptr) {
+      stats_->onStage(stage_, std::chrono::steady_clock::now() - start_);
+    }
+  }
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+
+ private:
+  VerifyStats* const stats_;
+  const VerifyStats::Stage stage_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * VerifyStats counting the events with relaxed atomics, to be read by a
+ * host exporting them periodically.
+ */
+class VerifyCounters : public VerifyStats {
+ public:
+  // The number of Status values, up to the last one.
+  static constexpr size_t kNumStatuses =
+      static_cast<size_t>(Status::JwksFetchError) + 1;
+
+  void onStage(Stage stage, std::chrono::nanoseconds duration) override;
+  void onKeysTried(size_t keys) override;
+  void onCacheLookup(bool hit) override;
+  void onFailure(Status status) override;
+
+  // The number of steps of a stage.
+  uint64_t stageCount(Stage stage) const;
+  // The total time spent in a stage, in nanoseconds.
+  uint64_t stageNanos(Stage stage) const;
+  // The number of tokens whose signature was checked.
+  uint64_t verifiedTokens() const { return load(verified_tokens_); }
+  // The number of keys tried for all these tokens.
+  uint64_t keysTried() const { return load(keys_tried_); }
+  uint64_t cacheHits() const { return load(cache_hits_); }
+  uint64_t cacheMisses() const { return load(cache_misses_); }
+  // The number of failures with the status.
+  uint64_t failures(Status status) const;
+
+ private:
+  static uint64_t load(const std::atomic<uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, kNumStages> stage_counts_{};
+  std::array<std::atomic<uint64_t>, kNumStages> stage_nanos_{};
+  std::atomic<uint64_t> verified_tokens_{0};
+  std::atomic<uint64_t> keys_tried_{0};
+  std::atomic<uint64_t> cache_hits_{0};
+  std::atomic<uint64_t> cache_misses_{0};
+  std::array<std::atomic<uint64_t>, kNumStatuses> failures_{};
+};
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -45,6 +45,28 @@ def googletest_repositories(bind = True):
             actual = "@googletest_git//:googletest_prod",
         )
 
+BENCHMARK_RELEASE = "1.5.0"
+BENCHMARK_SHA256 = "3c6a165b6ecc948967a1ead710d4a181d7b0fbcaa183ef7ea84604994966221a"
+
+def benchmark_repositories(bind = True):
+    http_archive(
+        name = "com_github_google_benchmark",
+        strip_prefix = "benchmark-" + BENCHMARK_RELEASE,
+        url = "https://github.com/google/benchmark/archive/v" + BENCHMARK_RELEASE + ".tar.gz",
+        sha256 = BENCHMARK_SHA256,
+    )
+
+    if bind:
+        native.bind(
+            name = "benchmark",
+            actual = "@com_github_google_benchmark//:benchmark",
+        )
+
+        native.bind(
+            name = "benchmark_main",
+            actual = "@com_github_google_benchmark//:benchmark_main",
+        )
+
 ABSEIL_COMMIT = "cc8dcd307b76a575d2e3e0958a4fe4c7193c2f68"  # same as Envoy
 ABSEIL_SHA256 = "e35082e88b9da04f4d68094c05ba112502a5063712f3021adfa465306d238c76"
 
@@ -73,6 +95,14 @@ def abseil_repositories(bind = True):
             name = "abseil_flat_hash_map",
             actual = "@com_google_absl//absl/container:flat_hash_map",
         )
+        native.bind(
+            name = "abseil_hash",
+            actual = "@com_google_absl//absl/hash:hash",
+        )
+        native.bind(
+            name = "abseil_span",
+            actual = "@com_google_absl//absl/types:span",
+        )
     _cctz_repositories(bind)
 
 CCTZ_COMMIT = "e19879df3a14791b7d483c359c4acd6b2a1cd96b"
@@ -0,0 +1,264 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A cache with an approximate LRU policy whose lookups take no lock.
+//
+// . Values are immutable and shared: lookup returns a
+//   "std::shared_ptr<const Value>" that stays valid after the entry is
+//   evicted, so there is nothing to release.
+//
+// . Entries live in an open addressing table whose slots are read with
+//   the std::atomic_load overloads for shared_ptr, and lookups never wait
+//   for writers. Note the standard library may implement these atomics with
+//   a small pool of internal locks hashed by address, which readers only
+//   hold for the duration of a pointer copy.
+//
+// . Recency is tracked CLOCK style: a lookup sets the "referenced" bit of the
+//   entry, and when the cache is full the clock hand evicts the first entry
+//   whose bit is clear, clearing the bits it passes. Unlike SimpleLRUCache no
+//   list is updated on a hit.
+//
+// . Writes (insert, remove, clear) are serialized by a mutex.
+
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "simple_lru_cache/simple_lru_cache.h"
+
+namespace google {
+namespace simple_lru_cache {
+
+template <typename Key, typename Value,
+          typename H = internal::SimpleLRUHash<Key>,
+          typename EQ = std::equal_to<Key>>
+class ClockCache {
+ public:
+  // Create a cache that will hold up to "max_entries" entries, at least one.
+  explicit ClockCache(size_t max_entries)
+      : max_entries_(max_entries == 0 ? 1 : max_entries),
+        table_(std::make_shared<Table>(tableSize(max_entries_))) {}
+
+  ClockCache(const ClockCache&) = delete;
+  ClockCache& operator=(const ClockCache&) = delete;
+
+  // If cache contains an entry for "k", return its value and mark the entry
+  // as recently used. Else return nullptr.
+  std::shared_ptr<const Value> lookup(const Key& k) const {
+    const size_t hash = H()(k);
+    const std::shared_ptr<Table> table = std::atomic_load(&table_);
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+      const std::shared_ptr<const Entry> entry =
+          std::atomic_load(&table->slots[i]);
+      if (entry == nullptr) {
+        return nullptr;
+      }
+      if (entry->value != nullptr && entry->hash == hash &&
+          EQ()(entry->key, k)) {
+        if (!entry->referenced.load(std::memory_order_relaxed)) {
+          entry->referenced.store(true, std::memory_order_relaxed);
+        }
+        return entry->value;
+      }
+    }
+  }
+
+  // Insert the specified "k,value" pair in the cache, replacing any old
+  // entry for "k". If the cache is full an entry is evicted.
+  void insert(const Key& k, std::shared_ptr<const Value> value) {
+    if (value == nullptr) {
+      remove(k);
+      return;
+    }
+    const size_t hash = H()(k);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Table* table = table_.get();
+    size_t free_slot = kNoSlot;
+    size_t i = hash & table->mask;
+    for (;; i = (i + 1) & table->mask) {
+      const std::shared_ptr<const Entry>& entry = table->slots[i];
+      if (entry == nullptr) {
+        break;
+      }
+      if (entry->value == nullptr) {
+        if (free_slot == kNoSlot) free_slot = i;
+      } else if (entry->hash == hash && EQ()(entry->key, k)) {
+        std::atomic_store(&table->slots[i], std::shared_ptr<const Entry>(
+                                                new Entry(k, hash, value)));
+        return;
+      }
+    }
+
+    if (live_ == max_entries_) {
+      evictOne();
+      // The evicted slot may be the first free one of the probe sequence.
+      free_slot = kNoSlot;
+      for (i = hash & table->mask; table->slots[i] != nullptr;
+           i = (i + 1) & table->mask) {
+        if (table->slots[i]->value == nullptr) {
+          free_slot = i;
+          break;
+        }
+      }
+    }
+    if (free_slot == kNoSlot) {
+      free_slot = i;
+    } else {
+      --tombstones_;
+    }
+    std::atomic_store(&table->slots[free_slot], std::shared_ptr<const Entry>(
+                                                    new Entry(k, hash, value)));
+    ++live_;
+    entries_.store(live_, std::memory_order_relaxed);
+
+    // Keep a quarter of the slots empty so that probe sequences end early.
+    if (live_ + tombstones_ > table->slots.size() / 4 * 3) {
+      rebuild();
+    }
+  }
+
+  // Remove any entry corresponding to "k" from the cache. Values already
+  // returned by lookup stay valid.
+  void remove(const Key& k) {
+    const size_t hash = H()(k);
+    std::lock_guard<std::mutex> lock(mutex_);
+    Table* table = table_.get();
+    for (size_t i = hash & table->mask; table->slots[i] != nullptr;
+         i = (i + 1) & table->mask) {
+      const std::shared_ptr<const Entry>& entry = table->slots[i];
+      if (entry->value != nullptr && entry->hash == hash &&
+          EQ()(entry->key, k)) {
+        removeAt(i);
+        return;
+      }
+    }
+  }
+
+  // Remove all entries from the cache.
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::atomic_store(&table_,
+                      std::make_shared<Table>(table_->slots.size()));
+    live_ = 0;
+    tombstones_ = 0;
+    hand_ = 0;
+    entries_.store(0, std::memory_order_relaxed);
+  }
+
+  // Return number of entries in the cache.
+  size_t entries() const { return entries_.load(std::memory_order_relaxed); }
+
+  // Return maximum number of entries in the cache.
+  size_t maxEntries() const { return max_entries_; }
+
+ private:
+  struct Entry {
+    Entry(const Key& k, size_t h, std::shared_ptr<const Value> v)
+        : key(k), hash(h), value(std::move(v)) {}
+
+    const Key key;
+    const size_t hash;
+    // nullptr for a removed entry, which keeps probe sequences going.
+    const std::shared_ptr<const Value> value;
+    // Set by lookup, cleared by the clock hand.
+    mutable std::atomic<bool> referenced{true};
+  };
+
+  struct Table {
+    explicit Table(size_t size) : slots(size), mask(size - 1) {}
+
+    std::vector<std::shared_ptr<const Entry>> slots;
+    const size_t mask;
+  };
+
+  static constexpr size_t kNoSlot = static_cast<size_t>(-1);
+
+  // A power of two with at least twice as many slots as entries.
+  static size_t tableSize(size_t max_entries) {
+    size_t size = 2;
+    while (size < max_entries * 2) size *= 2;
+    return size;
+  }
+
+  // Replace the entry at "i" with a removed entry. Requires "mutex_".
+  void removeAt(size_t i) {
+    Table* table = table_.get();
+    const Entry& entry = *table->slots[i];
+    std::atomic_store(
+        &table->slots[i],
+        std::shared_ptr<const Entry>(new Entry(entry.key, entry.hash,
+                                               nullptr)));
+    --live_;
+    ++tombstones_;
+    entries_.store(live_, std::memory_order_relaxed);
+  }
+
+  // Evict the first entry after the clock hand that was not looked up since
+  // the hand last passed it. Requires "mutex_" and a non empty cache.
+  void evictOne() {
+    Table* table = table_.get();
+    for (;; hand_ = (hand_ + 1) & table->mask) {
+      const std::shared_ptr<const Entry>& entry = table->slots[hand_];
+      if (entry == nullptr || entry->value == nullptr) {
+        continue;
+      }
+      if (entry->referenced.exchange(false, std::memory_order_relaxed)) {
+        continue;
+      }
+      removeAt(hand_);
+      hand_ = (hand_ + 1) & table->mask;
+      return;
+    }
+  }
+
+  // Publish a new table holding only the live entries. Requires "mutex_".
+  void rebuild() {
+    const Table& old_table = *table_;
+    std::shared_ptr<Table> table =
+        std::make_shared<Table>(old_table.slots.size());
+    for (const auto& entry : old_table.slots) {
+      if (entry == nullptr || entry->value == nullptr) {
+        continue;
+      }
+      size_t i = entry->hash & table->mask;
+      while (table->slots[i] != nullptr) i = (i + 1) & table->mask;
+      table->slots[i] = entry;
+    }
+    std::atomic_store(&table_, std::move(table));
+    tombstones_ = 0;
+    hand_ = 0;
+  }
+
+  const size_t max_entries_;
+  // Read by lookups without "mutex_", only replaced with atomic_store.
+  std::shared_ptr<Table> table_;
+
+  std::mutex mutex_;
+  // The following are guarded by "mutex_".
+  size_t live_ = 0;
+  size_t tombstones_ = 0;
+  size_t hand_ = 0;
+
+  // A copy of "live_" for entries().
+  std::atomic<size_t> entries_{0};
+};
+
+template <typename Key, typename Value, typename H, typename EQ>
+constexpr size_t ClockCache<Key, Value, H, EQ>::kNoSlot;
+
+}  // namespace simple_lru_cache
+}  // namespace google
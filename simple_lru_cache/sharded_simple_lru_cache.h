@@ -0,0 +1,279 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+    http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// A thread safe cache made of independently locked SimpleLRUCache shards.
+//
+// . Keys are assigned to shards by hash, so threads working on keys of
+//   different shards don't contend on a lock.
+//
+// . The size budget is split evenly across the shards, and the LRU order
+//   and the evictions are per shard: an entry may be evicted while another
+//   shard has entries less recently used.
+//
+// . As for SimpleLRUCache, lookup returns a "Value*" that stays valid until
+//   "release" is called for it. Unlike SimpleLRUCache, the caller must not
+//   hold any lock: each call locks the shard of the key.
+//
+// . All the values must be released before the cache is destroyed.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "simple_lru_cache/simple_lru_cache.h"
+#include "simple_lru_cache/simple_lru_cache_inl.h"
+
+namespace google {
+namespace simple_lru_cache {
+
+template <typename Key, typename Value, typename H, typename EQ>
+class ShardedSimpleLRUCache {
+ public:
+  // Automatically releases a value found by lookup, see
+  // SimpleLRUCacheBase::ScopedLookup.
+  class ScopedLookup {
+   public:
+    ScopedLookup(ShardedSimpleLRUCache* cache, const Key& key)
+        : cache_(cache), key_(key), value_(cache_->lookup(key_)) {}
+
+    ~ScopedLookup() {
+      if (value_ != nullptr) cache_->release(key_, value_);
+    }
+    const Key& key() const { return key_; }
+    Value* value() const { return value_; }
+    bool found() const { return value_ != nullptr; }
+
+   private:
+    ShardedSimpleLRUCache* const cache_;
+    const Key key_;
+    Value* const value_;
+
+    GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ScopedLookup);
+  };
+
+  // Create a cache of "num_shards" shards, at least one, that together hold
+  // up to the specified number of units.
+  ShardedSimpleLRUCache(size_t num_shards, int64_t total_units) {
+    if (num_shards == 0) num_shards = 1;
+    shards_.reserve(num_shards);
+    for (size_t i = 0; i < num_shards; ++i) {
+      shards_.emplace_back(new Shard(shardUnits(total_units, num_shards, i)));
+    }
+  }
+
+  ~ShardedSimpleLRUCache() { clear(); }
+
+  // Change the maximum size of the cache, each shard gets an equal part.
+  // If necessary, entries will be evicted to comply with the new size.
+  void setMaxSize(int64_t total_units) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i]->mutex);
+      shards_[i]->cache.setMaxSize(
+          shardUnits(total_units, shards_.size(), i));
+    }
+  }
+
+  // See SimpleLRUCacheBase::setMaxIdleSeconds().
+  void setMaxIdleSeconds(double seconds) {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.setMaxIdleSeconds(seconds);
+    }
+  }
+
+  // See SimpleLRUCacheBase::setAgeBasedEviction().
+  void setAgeBasedEviction(double seconds) {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.setAgeBasedEviction(seconds);
+    }
+  }
+
+  // See SimpleLRUCacheBase::lookup().
+  Value* lookup(const Key& k) {
+    Shard& shard = shardFor(k);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.cache.lookup(k);
+  }
+
+  // See SimpleLRUCacheBase::release().
+  void release(const Key& k, Value* value) {
+    Shard& shard = shardFor(k);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.release(k, value);
+  }
+
+  // See SimpleLRUCacheBase::insert().
+  void insert(const Key& k, Value* value, size_t units) {
+    Shard& shard = shardFor(k);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.insert(k, value, units);
+  }
+
+  // Insert as insert() does, after removing the entries of the shard of "k"
+  // for which "expired(*value)" returns true. The shard is only scanned if
+  // "epoch" is past the epoch of its previous scan, e.g. the current second,
+  // so that the sweeps cost at most one pass over each shard per epoch.
+  template <typename Expired>
+  void insertAndSweep(const Key& k, Value* value, size_t units, int64_t epoch,
+                      const Expired& expired) {
+    Shard& shard = shardFor(k);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (epoch > shard.sweep_epoch) {
+      shard.sweep_epoch = epoch;
+      sweep(shard, expired);
+    }
+    shard.cache.insert(k, value, units);
+  }
+
+  // See SimpleLRUCacheBase::insertPinned().
+  void insertPinned(const Key& k, Value* value, size_t units) {
+    Shard& shard = shardFor(k);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.insertPinned(k, value, units);
+  }
+
+  // See SimpleLRUCacheBase::remove().
+  void remove(const Key& k) {
+    Shard& shard = shardFor(k);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.cache.remove(k);
+  }
+
+  // See SimpleLRUCacheBase::removeAll().
+  void removeAll() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.removeAll();
+    }
+  }
+
+  // See SimpleLRUCacheBase::removeUnpinned().
+  void removeUnpinned() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.removeUnpinned();
+    }
+  }
+
+  // See SimpleLRUCacheBase::removeExpiredEntries().
+  void removeExpiredEntries() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.removeExpiredEntries();
+    }
+  }
+
+  // Remove the entries of all the shards for which "expired(*value)" returns
+  // true. As for remove(), a pinned entry is deleted once released.
+  template <typename Expired>
+  void removeIf(const Expired& expired) {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      sweep(*shard, expired);
+    }
+  }
+
+  // See SimpleLRUCacheBase::clear().
+  void clear() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      shard->cache.clear();
+    }
+  }
+
+  // Return current size of cache, the sum over the shards.
+  int64_t size() const {
+    int64_t total = 0;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      total += shard->cache.size();
+    }
+    return total;
+  }
+
+  // Return number of entries in the cache, the sum over the shards.
+  int64_t entries() const {
+    int64_t total = 0;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      total += shard->cache.entries();
+    }
+    return total;
+  }
+
+  // Return maximum size of cache, the sum over the shards.
+  int64_t maxSize() const {
+    int64_t total = 0;
+    for (const auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex);
+      total += shard->cache.maxSize();
+    }
+    return total;
+  }
+
+  // Return the number of shards.
+  size_t numShards() const { return shards_.size(); }
+
+  // Return the shard of "k", in [0, numShards()).
+  size_t shardIndex(const Key& k) const {
+    // Uses the high bits of a multiplicative hash, so that a shard doesn't
+    // get keys agreeing on the low bits that the shard's own table uses.
+    const uint64_t h = static_cast<uint64_t>(H()(k)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>((h >> 32) % shards_.size());
+  }
+
+ private:
+  struct Shard {
+    explicit Shard(int64_t total_units) : cache(total_units) {}
+
+    mutable std::mutex mutex;
+    SimpleLRUCache<Key, Value, H, EQ> cache;
+    // The epoch of the last sweep by insertAndSweep().
+    int64_t sweep_epoch = std::numeric_limits<int64_t>::min();
+  };
+
+  // Remove the entries of "shard" for which "expired(*value)" returns true.
+  // REQUIRES: the shard is locked.
+  template <typename Expired>
+  static void sweep(Shard& shard, const Expired& expired) {
+    std::vector<Key> keys;
+    for (const auto& entry : shard.cache) {
+      if (expired(*entry.second)) keys.push_back(entry.first);
+    }
+    for (const Key& key : keys) shard.cache.remove(key);
+  }
+
+  // The part of "total_units" for shard "i", the remainder goes to the
+  // first shards.
+  static int64_t shardUnits(int64_t total_units, size_t num_shards,
+                            size_t i) {
+    const int64_t n = static_cast<int64_t>(num_shards);
+    return total_units / n +
+           (static_cast<int64_t>(i) < total_units % n ? 1 : 0);
+  }
+
+  Shard& shardFor(const Key& k) { return *shards_[shardIndex(k)]; }
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  GOOGLE_DISALLOW_EVIL_CONSTRUCTORS(ShardedSimpleLRUCache);
+};
+
+}  // namespace simple_lru_cache
+}  // namespace google
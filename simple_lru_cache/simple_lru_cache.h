@@ -41,5 +41,10 @@ template <typename Key, typename Value, typename Deleter,
           typename EQ = std::equal_to<Key>>
 class SimpleLRUCacheWithDeleter;
 
+template <typename Key, typename Value,
+          typename H = internal::SimpleLRUHash<Key>,
+          typename EQ = std::equal_to<Key>>
+class ShardedSimpleLRUCache;
+
 }  // namespace simple_lru_cache
 }  // namespace google
\ No newline at end of file
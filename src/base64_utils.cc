@@ -0,0 +1,320 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/base64_utils.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+// The value of each base64url character, -1 for the others.
+constexpr int8_t kDecodeTable[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+    -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, 63,
+    -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+// The whitespace skipped by absl::WebSafeBase64Unescape.
+inline bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+// Decodes in one character at a time, the same way as
+// absl::WebSafeBase64Unescape.
+bool decodeScalar(const char* in, size_t len, uint8_t* out, size_t* out_len) {
+  const uint8_t* const out_begin = out;
+  uint32_t bits = 0;
+  int chars = 0;
+  size_t i = 0;
+  for (; i < len; ++i) {
+    const int8_t value = kDecodeTable[static_cast<uint8_t>(in[i])];
+    if (value >= 0) {
+      bits = (bits << 6) | value;
+      if (++chars == 4) {
+        *out++ = bits >> 16;
+        *out++ = bits >> 8;
+        *out++ = bits;
+        bits = 0;
+        chars = 0;
+      }
+    } else if (!isSpace(in[i])) {
+      // Padding, or an invalid character rejected below.
+      break;
+    }
+  }
+
+  // The padding completes the last group of 4 characters.
+  int expected_padding = 0;
+  switch (chars) {
+    case 1:
+      return false;
+    case 2:
+      *out++ = bits >> 4;
+      expected_padding = 2;
+      break;
+    case 3:
+      *out++ = bits >> 10;
+      *out++ = bits >> 2;
+      expected_padding = 1;
+      break;
+  }
+  int padding = 0;
+  for (; i < len; ++i) {
+    if (in[i] == '=' || in[i] == '.') {
+      ++padding;
+    } else if (!isSpace(in[i])) {
+      return false;
+    }
+  }
+  if (padding != 0 && padding != expected_padding) {
+    return false;
+  }
+  *out_len = out - out_begin;
+  return true;
+}
+
+#if defined(__AVX2__)
+
+// The characters decoded by a block.
+constexpr size_t kBlockSize = 32;
+// Blocks are only decoded if there are at least that many characters left,
+// so that the bytes stored past the block are still within out.
+constexpr size_t kMinBlockInput = 48;
+
+// Decodes 32 characters into 24 bytes, storing 28 bytes. Returns false
+// without storing anything if a character isn't in the alphabet.
+inline bool decodeBlock(const char* in, uint8_t* out) {
+  const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+  // The bytes above 0x7f are negative and fail all the ranges.
+  auto inRange = [&c](char lo, char hi) {
+    return _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8(lo - 1)),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), c));
+  };
+  const __m256i upper = inRange('A', 'Z');
+  const __m256i lower = inRange('a', 'z');
+  const __m256i digit = inRange('0', '9');
+  const __m256i dash = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-'));
+  const __m256i underscore = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+  const __m256i valid = _mm256_or_si256(
+      _mm256_or_si256(_mm256_or_si256(upper, lower), digit),
+      _mm256_or_si256(dash, underscore));
+  if (_mm256_movemask_epi8(valid) != -1) {
+    return false;
+  }
+  const __m256i offset = _mm256_or_si256(
+      _mm256_or_si256(
+          _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-65)),
+                          _mm256_and_si256(lower, _mm256_set1_epi8(-71))),
+          _mm256_and_si256(digit, _mm256_set1_epi8(4))),
+      _mm256_or_si256(_mm256_and_si256(dash, _mm256_set1_epi8(17)),
+                      _mm256_and_si256(underscore, _mm256_set1_epi8(-32))));
+  const __m256i values = _mm256_add_epi8(c, offset);
+
+  // Merge the 6 bits values into 24 bits per 32 bits lane, then keep the 3
+  // bytes of each lane in big-endian order.
+  const __m256i pairs =
+      _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+  const __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+  const __m256i bytes = _mm256_shuffle_epi8(
+      quads, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                              -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                              -1, -1, -1, -1));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                   _mm256_castsi256_si128(bytes));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12),
+                   _mm256_extracti128_si256(bytes, 1));
+  return true;
+}
+
+#elif defined(__SSE2__)
+
+// The characters decoded by a block.
+constexpr size_t kBlockSize = 16;
+// Blocks are only decoded if there are at least that many characters left,
+// so that the bytes stored past the block are still within out.
+constexpr size_t kMinBlockInput = 32;
+
+// Decodes 16 characters into 12 bytes, storing 16 bytes with SSSE3. Returns
+// false without storing anything if a character isn't in the alphabet.
+inline bool decodeBlock(const char* in, uint8_t* out) {
+  const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  // The bytes above 0x7f are negative and fail all the ranges.
+  auto inRange = [&c](char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8(lo - 1)),
+                         _mm_cmplt_epi8(c, _mm_set1_epi8(hi + 1)));
+  };
+  const __m128i upper = inRange('A', 'Z');
+  const __m128i lower = inRange('a', 'z');
+  const __m128i digit = inRange('0', '9');
+  const __m128i dash = _mm_cmpeq_epi8(c, _mm_set1_epi8('-'));
+  const __m128i underscore = _mm_cmpeq_epi8(c, _mm_set1_epi8('_'));
+  const __m128i valid =
+      _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), digit),
+                   _mm_or_si128(dash, underscore));
+  if (_mm_movemask_epi8(valid) != 0xffff) {
+    return false;
+  }
+  const __m128i offset = _mm_or_si128(
+      _mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-65)),
+                                _mm_and_si128(lower, _mm_set1_epi8(-71))),
+                   _mm_and_si128(digit, _mm_set1_epi8(4))),
+      _mm_or_si128(_mm_and_si128(dash, _mm_set1_epi8(17)),
+                   _mm_and_si128(underscore, _mm_set1_epi8(-32))));
+  const __m128i values = _mm_add_epi8(c, offset);
+
+#if defined(__SSSE3__)
+  // Merge the 6 bits values into 24 bits per 32 bits lane, then keep the 3
+  // bytes of each lane in big-endian order.
+  const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out),
+      _mm_shuffle_epi8(quads, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+                                            12, -1, -1, -1, -1)));
+#else
+  // Merge the 6 bits values into 24 bits per 32 bits lane.
+  const __m128i mask16 = _mm_set1_epi32(0x0000ffff);
+  const __m128i low = _mm_and_si128(values, _mm_set1_epi16(0xff));
+  const __m128i pairs =
+      _mm_or_si128(_mm_slli_epi16(low, 6), _mm_srli_epi16(values, 8));
+  const __m128i quads =
+      _mm_or_si128(_mm_slli_epi32(_mm_and_si128(pairs, mask16), 12),
+                   _mm_srli_epi32(pairs, 16));
+  uint32_t lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), quads);
+  for (uint32_t lane : lanes) {
+    *out++ = lane >> 16;
+    *out++ = lane >> 8;
+    *out++ = lane;
+  }
+#endif
+  return true;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+
+// The characters decoded by a block.
+constexpr size_t kBlockSize = 64;
+// A block stores exactly the 48 bytes it decodes.
+constexpr size_t kMinBlockInput = 64;
+
+// Returns the 6 bits values of 16 characters, and clears valid in the lanes
+// whose character isn't in the alphabet.
+inline uint8x16_t decodeChars(uint8x16_t c, uint8x16_t* valid) {
+  auto inRange = [&c](uint8_t lo, uint8_t hi) {
+    return vandq_u8(vcgeq_u8(c, vdupq_n_u8(lo)), vcleq_u8(c, vdupq_n_u8(hi)));
+  };
+  const uint8x16_t upper = inRange('A', 'Z');
+  const uint8x16_t lower = inRange('a', 'z');
+  const uint8x16_t digit = inRange('0', '9');
+  const uint8x16_t dash = vceqq_u8(c, vdupq_n_u8('-'));
+  const uint8x16_t underscore = vceqq_u8(c, vdupq_n_u8('_'));
+  *valid = vandq_u8(*valid, vorrq_u8(vorrq_u8(vorrq_u8(upper, lower), digit),
+                                     vorrq_u8(dash, underscore)));
+  // The offsets wrap around, e.g. 191 subtracts 65.
+  const uint8x16_t offset = vorrq_u8(
+      vorrq_u8(vorrq_u8(vandq_u8(upper, vdupq_n_u8(191)),
+                        vandq_u8(lower, vdupq_n_u8(185))),
+               vandq_u8(digit, vdupq_n_u8(4))),
+      vorrq_u8(vandq_u8(dash, vdupq_n_u8(17)),
+               vandq_u8(underscore, vdupq_n_u8(224))));
+  return vaddq_u8(c, offset);
+}
+
+// Decodes 64 characters into 48 bytes. Returns false without storing
+// anything if a character isn't in the alphabet.
+inline bool decodeBlock(const char* in, uint8_t* out) {
+  // Characters 4 * i + j are in c.val[j].
+  const uint8x16x4_t c = vld4q_u8(reinterpret_cast<const uint8_t*>(in));
+  uint8x16_t valid = vdupq_n_u8(0xff);
+  const uint8x16_t v0 = decodeChars(c.val[0], &valid);
+  const uint8x16_t v1 = decodeChars(c.val[1], &valid);
+  const uint8x16_t v2 = decodeChars(c.val[2], &valid);
+  const uint8x16_t v3 = decodeChars(c.val[3], &valid);
+  if (vminvq_u8(valid) != 0xff) {
+    return false;
+  }
+  uint8x16x3_t bytes;
+  bytes.val[0] = vorrq_u8(vshlq_n_u8(v0, 2), vshrq_n_u8(v1, 4));
+  bytes.val[1] = vorrq_u8(vshlq_n_u8(v1, 4), vshrq_n_u8(v2, 2));
+  bytes.val[2] = vorrq_u8(vshlq_n_u8(v2, 6), v3);
+  vst3q_u8(out, bytes);
+  return true;
+}
+
+#else
+#define JWT_VERIFY_LIB_SCALAR_BASE64
+#endif
+
+}  // namespace
+
+bool base64UrlDecode(absl::string_view in, uint8_t* out, size_t* out_len) {
+  const char* data = in.data();
+  size_t len = in.size();
+  uint8_t* const out_begin = out;
+#ifndef JWT_VERIFY_LIB_SCALAR_BASE64
+  // Most of a token is in blocks without padding or whitespace, the first
+  // block which isn't is left to decodeScalar.
+  while (len >= kMinBlockInput && decodeBlock(data, out)) {
+    data += kBlockSize;
+    len -= kBlockSize;
+    out += kBlockSize / 4 * 3;
+  }
+#endif
+  size_t tail_len = 0;
+  if (!decodeScalar(data, len, out, &tail_len)) {
+    return false;
+  }
+  *out_len = out - out_begin + tail_len;
+  return true;
+}
+
+bool base64UrlDecode(absl::string_view in, std::string* out) {
+  out->resize(base64UrlDecodedMaxSize(in.size()));
+  size_t out_len = 0;
+  if (!base64UrlDecode(in, reinterpret_cast<uint8_t*>(&(*out)[0]),
+                       &out_len)) {
+    out->clear();
+    return false;
+  }
+  out->resize(out_len);
+  return true;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
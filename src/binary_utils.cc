@@ -0,0 +1,76 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/binary_utils.h"
+
+namespace google {
+namespace jwt_verify {
+
+void appendUInt32(uint32_t value, std::string* out) {
+  for (int i = 0; i < 4; ++i) {
+    out->push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+void appendBytes(absl::string_view bytes, std::string* out) {
+  appendUInt32(bytes.length(), out);
+  out->append(bytes.data(), bytes.length());
+}
+
+bool BinaryReader::readBytes(size_t length, absl::string_view* value) {
+  if (data_.length() < length) {
+    return false;
+  }
+  *value = data_.substr(0, length);
+  data_.remove_prefix(length);
+  return true;
+}
+
+bool BinaryReader::readUInt8(uint8_t* value) {
+  absl::string_view bytes;
+  if (!readBytes(1, &bytes)) {
+    return false;
+  }
+  *value = static_cast<uint8_t>(bytes[0]);
+  return true;
+}
+
+bool BinaryReader::readUInt32(uint32_t* value) {
+  absl::string_view bytes;
+  if (!readBytes(4, &bytes)) {
+    return false;
+  }
+  *value = 0;
+  for (int i = 0; i < 4; ++i) {
+    *value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[i])) << (8 * i);
+  }
+  return true;
+}
+
+bool BinaryReader::readString(absl::string_view* value) {
+  uint32_t length;
+  return readUInt32(&length) && readBytes(length, value);
+}
+
+bool BinaryReader::readString(std::string* value) {
+  absl::string_view bytes;
+  if (!readString(&bytes)) {
+    return false;
+  }
+  value->assign(bytes.data(), bytes.length());
+  return true;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -25,7 +25,7 @@ constexpr absl::string_view HTTPSchemePrefix("http://");
 // HTTPS Protocol scheme prefix in JWT aud claim.
 constexpr absl::string_view HTTPSSchemePrefix("https://");
 
-std::string sanitizeAudience(const std::string& aud) {
+absl::string_view sanitizeAudience(absl::string_view aud) {
   if (aud.empty()) {
     return aud;
   }
@@ -48,6 +48,7 @@ std::string sanitizeAudience(const std::string& aud) {
     sanitized = true;
   }
   if (sanitized) {
+    // A view, without copying.
     return aud.substr(beg_pos, end_pos - beg_pos);
   }
   return aud;
@@ -57,7 +58,7 @@ std::string sanitizeAudience(const std::string& aud) {
 
 CheckAudience::CheckAudience(const std::vector<std::string>& config_audiences) {
   for (const auto& aud : config_audiences) {
-    config_audiences_.insert(sanitizeAudience(aud));
+    config_audiences_.emplace(sanitizeAudience(aud));
   }
 }
 
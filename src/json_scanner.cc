@@ -0,0 +1,450 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/json_scanner.h"
+
+#include <cmath>
+
+#include "absl/strings/numbers.h"
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+// JsonStringToMessage limits the nesting of the messages representing a
+// Struct: the top level Struct, a map entry per key, a Value per value and a
+// Struct or ListValue per nested object or array.
+constexpr int kMaxDepth = 101;
+
+bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isIdentifierStart(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+         c == '$';
+}
+
+bool isIdentifierChar(char c) { return isIdentifierStart(c) || isDigit(c); }
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Returns the length of the UTF-8 sequence at the start of str, or 0 if it is
+// not valid: truncated, overlong, a surrogate or above U+10FFFF.
+size_t utf8SequenceLength(absl::string_view str) {
+  const unsigned char lead = str[0];
+  size_t len;
+  uint32_t code_point;
+  uint32_t min_code_point;
+  if ((lead & 0xE0) == 0xC0) {
+    len = 2;
+    code_point = lead & 0x1F;
+    min_code_point = 0x80;
+  } else if ((lead & 0xF0) == 0xE0) {
+    len = 3;
+    code_point = lead & 0x0F;
+    min_code_point = 0x800;
+  } else if ((lead & 0xF8) == 0xF0) {
+    len = 4;
+    code_point = lead & 0x07;
+    min_code_point = 0x10000;
+  } else {
+    return 0;
+  }
+  if (str.size() < len) {
+    return 0;
+  }
+  for (size_t i = 1; i < len; ++i) {
+    const unsigned char c = str[i];
+    if ((c & 0xC0) != 0x80) {
+      return 0;
+    }
+    code_point = (code_point << 6) | (c & 0x3F);
+  }
+  if (code_point < min_code_point || code_point > 0x10FFFF ||
+      (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+    return 0;
+  }
+  return len;
+}
+
+void appendUtf8(uint32_t code_point, std::string* out) {
+  if (code_point < 0x80) {
+    out->push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out->push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out->push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out->push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out->push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+// Reads the 4 hex digits of a \u escape at the start of str.
+bool readHex4(absl::string_view str, uint32_t* value) {
+  if (str.size() < 4) {
+    return false;
+  }
+  *value = 0;
+  for (size_t i = 0; i < 4; ++i) {
+    const int digit = hexValue(str[i]);
+    if (digit < 0) {
+      return false;
+    }
+    *value = (*value << 4) | digit;
+  }
+  return true;
+}
+
+}  // namespace
+
+JsonScanner::JsonScanner(absl::string_view json) : json_(json) {}
+
+JsonScanner::Token JsonScanner::next() {
+  if (error_) {
+    return Error;
+  }
+  skipWhitespace();
+  if (frames_.empty()) {
+    if (done_) {
+      return pos_ == json_.size() ? End : fail();
+    }
+    // The top level must be an object.
+    if (pos_ < json_.size() && json_[pos_] == '{') {
+      ++pos_;
+      return beginContainer(true, 1);
+    }
+    return fail();
+  }
+  if (pos_ == json_.size()) {
+    return fail();
+  }
+
+  Frame& frame = frames_.back();
+  const char c = json_[pos_];
+  const char close = frame.is_object ? '}' : ']';
+  switch (frame.expect) {
+    case Member:
+      if (c == close) {
+        ++pos_;
+        return endContainer();
+      }
+      return frame.is_object ? readKey() : readValue(frame.depth);
+    case Value:
+      if (c != ':') {
+        return fail();
+      }
+      ++pos_;
+      skipWhitespace();
+      // The value of a key is nested in its map entry.
+      return readValue(frame.depth + 1);
+    case Separator:
+      if (c == ',') {
+        // A trailing comma before the closing bracket is allowed.
+        ++pos_;
+        frame.expect = Member;
+        return next();
+      }
+      if (c == close) {
+        ++pos_;
+        return endContainer();
+      }
+      return fail();
+  }
+  return fail();
+}
+
+bool JsonScanner::skipValue(Token token) {
+  if (token == Error) {
+    return false;
+  }
+  if (token != BeginObject && token != BeginArray) {
+    return true;
+  }
+  const size_t depth = frames_.size();
+  while (frames_.size() >= depth) {
+    if (next() == Error) {
+      return false;
+    }
+  }
+  return true;
+}
+
+JsonScanner::Token JsonScanner::fail() {
+  error_ = true;
+  return Error;
+}
+
+void JsonScanner::skipWhitespace() {
+  while (pos_ < json_.size() && isWhitespace(json_[pos_])) {
+    ++pos_;
+  }
+}
+
+JsonScanner::Token JsonScanner::readKey() {
+  const char c = json_[pos_];
+  if (c == '"' || c == '\'') {
+    if (!readString()) {
+      return fail();
+    }
+  } else if (isIdentifierStart(c)) {
+    const size_t start = pos_;
+    while (pos_ < json_.size() && isIdentifierChar(json_[pos_])) {
+      ++pos_;
+    }
+    str_ = json_.substr(start, pos_ - start);
+    if (str_ == "true" || str_ == "false" || str_ == "null") {
+      return fail();
+    }
+  } else {
+    return fail();
+  }
+
+  // Struct doesn't allow the same key twice in an object.
+  if (!keys_[open_objects_ - 1].emplace(str_).second) {
+    return fail();
+  }
+  frames_.back().expect = Value;
+  return Key;
+}
+
+JsonScanner::Token JsonScanner::readValue(int depth) {
+  frames_.back().expect = Separator;
+  if (pos_ == json_.size()) {
+    return fail();
+  }
+  const char c = json_[pos_];
+  if (c == '{' || c == '[') {
+    ++pos_;
+    // A Value holding a Struct or a ListValue.
+    return beginContainer(c == '{', depth + 2);
+  }
+  if (depth + 1 > kMaxDepth) {
+    return fail();
+  }
+  if (c == '"' || c == '\'') {
+    return readString() ? String : fail();
+  }
+  if (c == '-' || isDigit(c)) {
+    return readNumber() ? Number : fail();
+  }
+  if (readKeyword("true")) {
+    boolean_ = true;
+    return Bool;
+  }
+  if (readKeyword("false")) {
+    boolean_ = false;
+    return Bool;
+  }
+  if (readKeyword("null")) {
+    return Null;
+  }
+  return fail();
+}
+
+JsonScanner::Token JsonScanner::beginContainer(bool is_object, int depth) {
+  if (depth > kMaxDepth) {
+    return fail();
+  }
+  frames_.push_back({is_object, depth, Member});
+  if (!is_object) {
+    return BeginArray;
+  }
+  if (keys_.size() == open_objects_) {
+    keys_.emplace_back();
+  } else {
+    keys_[open_objects_].clear();
+  }
+  ++open_objects_;
+  return BeginObject;
+}
+
+JsonScanner::Token JsonScanner::endContainer() {
+  const bool is_object = frames_.back().is_object;
+  frames_.pop_back();
+  if (is_object) {
+    --open_objects_;
+  }
+  done_ = frames_.empty();
+  return is_object ? EndObject : EndArray;
+}
+
+bool JsonScanner::readString() {
+  const char quote = json_[pos_++];
+  const size_t start = pos_;
+
+  // Fast path: without escapes str_ points into the document.
+  while (pos_ < json_.size()) {
+    const char c = json_[pos_];
+    if (c == quote) {
+      str_ = json_.substr(start, pos_ - start);
+      ++pos_;
+      return true;
+    }
+    if (c == '\\') {
+      break;
+    }
+    if (static_cast<unsigned char>(c) < 0x80) {
+      ++pos_;
+      continue;
+    }
+    const size_t len = utf8SequenceLength(json_.substr(pos_));
+    if (len == 0) {
+      return false;
+    }
+    pos_ += len;
+  }
+  if (pos_ == json_.size()) {
+    return false;
+  }
+
+  str_buf_.assign(json_.data() + start, pos_ - start);
+  while (pos_ < json_.size()) {
+    const char c = json_[pos_];
+    if (c == quote) {
+      str_ = str_buf_;
+      ++pos_;
+      return true;
+    }
+    if (static_cast<unsigned char>(c) >= 0x80) {
+      const size_t len = utf8SequenceLength(json_.substr(pos_));
+      if (len == 0) {
+        return false;
+      }
+      str_buf_.append(json_.data() + pos_, len);
+      pos_ += len;
+      continue;
+    }
+    ++pos_;
+    if (c != '\\') {
+      // Control characters are accepted unescaped.
+      str_buf_.push_back(c);
+      continue;
+    }
+
+    if (pos_ == json_.size()) {
+      return false;
+    }
+    const char escaped = json_[pos_];
+    switch (escaped) {
+      case 'b':
+        str_buf_.push_back('\b');
+        break;
+      case 'f':
+        str_buf_.push_back('\f');
+        break;
+      case 'n':
+        str_buf_.push_back('\n');
+        break;
+      case 'r':
+        str_buf_.push_back('\r');
+        break;
+      case 't':
+        str_buf_.push_back('\t');
+        break;
+      case 'u': {
+        uint32_t code_point;
+        if (!readHex4(json_.substr(pos_ + 1), &code_point)) {
+          return false;
+        }
+        pos_ += 5;
+        if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+          return false;
+        }
+        if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+          // A high surrogate must be followed by an escaped low surrogate.
+          uint32_t low;
+          if (json_.substr(pos_, 2) != "\\u" ||
+              !readHex4(json_.substr(pos_ + 2), &low) || low < 0xDC00 ||
+              low > 0xDFFF) {
+            return false;
+          }
+          pos_ += 6;
+          code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+        }
+        appendUtf8(code_point, &str_buf_);
+        continue;
+      }
+      default:
+        // Any other escaped character stands for itself. A multi-byte
+        // character is left to be validated by the loop.
+        if (static_cast<unsigned char>(escaped) >= 0x80) {
+          continue;
+        }
+        str_buf_.push_back(escaped);
+        break;
+    }
+    ++pos_;
+  }
+  return false;
+}
+
+bool JsonScanner::readNumber() {
+  // Like JsonStringToMessage, take the run of number characters and convert
+  // it as a whole.
+  const size_t start = pos_;
+  const bool negative = json_[pos_] == '-';
+  if (negative) {
+    ++pos_;
+  }
+  const bool leading_zero = pos_ < json_.size() && json_[pos_] == '0';
+  bool floating = false;
+  while (pos_ < json_.size()) {
+    const char c = json_[pos_];
+    if (c == '.' || c == 'e' || c == 'E') {
+      floating = true;
+    } else if (!isDigit(c) && c != '+' && c != '-') {
+      break;
+    }
+    ++pos_;
+  }
+  const absl::string_view text = json_.substr(start, pos_ - start);
+
+  // Octal and hex integers are rejected.
+  if (!floating && leading_zero && text.size() > (negative ? 2u : 1u)) {
+    return false;
+  }
+  return absl::SimpleAtod(text, &number_) && std::isfinite(number_);
+}
+
+bool JsonScanner::readKeyword(absl::string_view keyword) {
+  if (json_.substr(pos_, keyword.size()) != keyword) {
+    return false;
+  }
+  pos_ += keyword.size();
+  return true;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -16,18 +16,25 @@
 
 #include <assert.h>
 
+#include <atomic>
 #include <iostream>
+#include <tuple>
+#include <utility>
 
-#include "absl/strings/escaping.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
 #include "absl/strings/match.h"
-#include "google/protobuf/struct.pb.h"
-#include "google/protobuf/util/json_util.h"
+#include "jwt_verify_lib/base64_utils.h"
+#include "jwt_verify_lib/binary_utils.h"
+#include "jwt_verify_lib/json_scanner.h"
 #include "jwt_verify_lib/struct_utils.h"
 #include "openssl/bio.h"
 #include "openssl/bn.h"
 #include "openssl/curve25519.h"
 #include "openssl/ecdsa.h"
+#include "openssl/err.h"
 #include "openssl/evp.h"
+#include "openssl/hmac.h"
 #include "openssl/rsa.h"
 #include "openssl/sha.h"
 
@@ -115,7 +122,7 @@ class KeyGetter : public WithStatus {
   std::string createRawKeyFromJwkOKP(int nid, size_t keylen,
                                      const std::string& x) {
     std::string x_decoded;
-    if (!absl::WebSafeBase64Unescape(x, &x_decoded)) {
+    if (!base64UrlDecode(x, &x_decoded)) {
       updateStatus(Status::JwksOKPXBadBase64);
     } else if (x_decoded.length() != keylen) {
       updateStatus(Status::JwksOKPXWrongLength);
@@ -127,8 +134,18 @@ class KeyGetter : public WithStatus {
  private:
   bssl::UniquePtr<BIGNUM> createBigNumFromBase64UrlString(
       const std::string& s) {
+    // Up to 8192 bits moduli are decoded on the stack.
+    uint8_t buffer[1024];
+    if (base64UrlDecodedMaxSize(s.size()) <= sizeof(buffer)) {
+      size_t len = 0;
+      if (!base64UrlDecode(s, buffer, &len)) {
+        return nullptr;
+      }
+      return bssl::UniquePtr<BIGNUM>(BN_bin2bn(buffer, len, NULL));
+    }
+
     std::string s_decoded;
-    if (!absl::WebSafeBase64Unescape(s, &s_decoded)) {
+    if (!base64UrlDecode(s, &s_decoded)) {
       return nullptr;
     }
     return bssl::UniquePtr<BIGNUM>(
@@ -136,17 +153,152 @@ class KeyGetter : public WithStatus {
   };
 };
 
-Status extractJwkFromJwkRSA(const ::google::protobuf::Struct& jwk_pb,
-                            Jwks::Pubkey* jwk) {
-  if (!jwk->alg_.empty() &&
-      (jwk->alg_.size() < 2 || (jwk->alg_.compare(0, 2, "RS") != 0 &&
-                                jwk->alg_.compare(0, 2, "PS") != 0))) {
+// The JWK fields the key is extracted from.
+const char* const kJwkFields[] = {"kty", "kid", "alg", "crv", "n",
+                                  "e",   "x",   "y",   "k"};
+
+// The fields of a JWK object read while the JWKS is scanned, so that no
+// Struct is built. GetString returns what StructUtils would return for the
+// same field of the equivalent Struct.
+class JwkFields {
+ public:
+  JwkFields() {
+    for (size_t i = 0; i < kNumFields; ++i) {
+      fields_[i].name = kJwkFields[i];
+    }
+  }
+
+  /**
+   * Reads the members of an object, after its BeginObject was returned.
+   * @return false if the document is not valid.
+   */
+  bool read(JsonScanner* scanner) {
+    for (Field& field : fields_) {
+      field.kind = Field::Missing;
+      field.value.clear();
+    }
+    for (;;) {
+      JsonScanner::Token token = scanner->next();
+      if (token == JsonScanner::EndObject) {
+        return true;
+      }
+      if (token != JsonScanner::Key) {
+        return false;
+      }
+      Field* field = find(scanner->str());
+      token = scanner->next();
+      if (field != nullptr && token == JsonScanner::String) {
+        field->kind = Field::String;
+        field->value = std::string(scanner->str());
+        continue;
+      }
+      if (field != nullptr) {
+        field->kind = Field::Other;
+      }
+      if (!scanner->skipValue(token)) {
+        return false;
+      }
+    }
+  }
+
+  StructUtils::FindResult GetString(absl::string_view name,
+                                    std::string* value) const {
+    const Field* field = find(name);
+    if (field == nullptr || field->kind == Field::Missing) {
+      return StructUtils::MISSING;
+    }
+    if (field->kind != Field::String) {
+      return StructUtils::WRONG_TYPE;
+    }
+    *value = field->value;
+    return StructUtils::OK;
+  }
+
+ private:
+  static constexpr size_t kNumFields =
+      sizeof(kJwkFields) / sizeof(kJwkFields[0]);
+
+  struct Field {
+    enum Kind { Missing, String, Other };
+
+    absl::string_view name;
+    Kind kind = Missing;
+    std::string value;
+  };
+
+  Field* find(absl::string_view name) {
+    for (Field& field : fields_) {
+      if (field.name == name) {
+        return &field;
+      }
+    }
+    return nullptr;
+  }
+
+  const Field* find(absl::string_view name) const {
+    return const_cast<JwkFields*>(this)->find(name);
+  }
+
+  Field fields_[kNumFields];
+};
+
+// The checks of the alg and crv of the keys, shared by the JWKs and the binary
+// keysets.
+
+Status checkRsaKeyAlg(const Jwks::Pubkey& jwk) {
+  if (!jwk.alg_.empty() &&
+      (jwk.alg_.size() < 2 || (jwk.alg_.compare(0, 2, "RS") != 0 &&
+                               jwk.alg_.compare(0, 2, "PS") != 0))) {
     return Status::JwksRSAKeyBadAlg;
   }
+  return Status::Ok;
+}
+
+Status checkEcKeyAlg(const Jwks::Pubkey& jwk) {
+  if (!jwk.alg_.empty() &&
+      (jwk.alg_.size() < 2 || jwk.alg_.compare(0, 2, "ES") != 0)) {
+    return Status::JwksECKeyBadAlg;
+  }
+  return Status::Ok;
+}
+
+// If both alg and crv specified, make sure they match
+Status checkEcKeyAlgAndCrv(const Jwks::Pubkey& jwk) {
+  if (!jwk.alg_.empty() && !jwk.crv_.empty()) {
+    if (!((jwk.alg_ == "ES256" && jwk.crv_ == "P-256") ||
+          (jwk.alg_ == "ES384" && jwk.crv_ == "P-384") ||
+          (jwk.alg_ == "ES512" && jwk.crv_ == "P-521"))) {
+      return Status::JwksECKeyAlgNotCompatibleWithCrv;
+    }
+  }
+  return Status::Ok;
+}
+
+Status checkOctKeyAlg(const Jwks::Pubkey& jwk) {
+  if (!jwk.alg_.empty() && jwk.alg_ != "HS256" && jwk.alg_ != "HS384" &&
+      jwk.alg_ != "HS512") {
+    return Status::JwksHMACKeyBadAlg;
+  }
+  return Status::Ok;
+}
+
+// alg is not required, but if present it must be EdDSA
+Status checkOkpKeyAlg(const Jwks::Pubkey& jwk) {
+  if (!jwk.alg_.empty() && jwk.alg_ != "EdDSA") {
+    return Status::JwksOKPKeyBadAlg;
+  }
+  return Status::Ok;
+}
+
+Status extractJwkFromJwkRSA(const JwkFields& jwk_fields,
+                            Jwks::Pubkey* jwk) {
+  Status status = checkRsaKeyAlg(*jwk);
+  if (status != Status::Ok) {
+    return status;
+  }
 
-  StructUtils jwk_getter(jwk_pb);
   std::string n_str;
-  auto code = jwk_getter.GetString("n", &n_str);
+  auto code = jwk_fields.GetString("n", &n_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksRSAKeyMissingN;
   }
@@ -155,7 +307,7 @@ Status extractJwkFromJwkRSA(const ::google::protobuf::Struct& jwk_pb,
   }
 
   std::string e_str;
-  code = jwk_getter.GetString("e", &e_str);
+  code = jwk_fields.GetString("e", &e_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksRSAKeyMissingE;
   }
@@ -168,16 +320,15 @@ Status extractJwkFromJwkRSA(const ::google::protobuf::Struct& jwk_pb,
   return e.getStatus();
 }
 
-Status extractJwkFromJwkEC(const ::google::protobuf::Struct& jwk_pb,
+Status extractJwkFromJwkEC(const JwkFields& jwk_fields,
                            Jwks::Pubkey* jwk) {
-  if (!jwk->alg_.empty() &&
-      (jwk->alg_.size() < 2 || jwk->alg_.compare(0, 2, "ES") != 0)) {
-    return Status::JwksECKeyBadAlg;
+  Status status = checkEcKeyAlg(*jwk);
+  if (status != Status::Ok) {
+    return status;
   }
 
-  StructUtils jwk_getter(jwk_pb);
   std::string crv_str;
-  auto code = jwk_getter.GetString("crv", &crv_str);
+  auto code = jwk_fields.GetString("crv", &crv_str);
   if (code == StructUtils::MISSING) {
     crv_str = "";
   }
@@ -186,13 +337,9 @@ Status extractJwkFromJwkEC(const ::google::protobuf::Struct& jwk_pb,
   }
   jwk->crv_ = crv_str;
 
-  // If both alg and crv specified, make sure they match
-  if (!jwk->alg_.empty() && !jwk->crv_.empty()) {
-    if (!((jwk->alg_ == "ES256" && jwk->crv_ == "P-256") ||
-          (jwk->alg_ == "ES384" && jwk->crv_ == "P-384") ||
-          (jwk->alg_ == "ES512" && jwk->crv_ == "P-521"))) {
-      return Status::JwksECKeyAlgNotCompatibleWithCrv;
-    }
+  status = checkEcKeyAlgAndCrv(*jwk);
+  if (status != Status::Ok) {
+    return status;
   }
 
   // If neither alg or crv is set, assume P-256
@@ -215,7 +362,7 @@ Status extractJwkFromJwkEC(const ::google::protobuf::Struct& jwk_pb,
   }
 
   std::string x_str;
-  code = jwk_getter.GetString("x", &x_str);
+  code = jwk_fields.GetString("x", &x_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksECKeyMissingX;
   }
@@ -224,7 +371,7 @@ Status extractJwkFromJwkEC(const ::google::protobuf::Struct& jwk_pb,
   }
 
   std::string y_str;
-  code = jwk_getter.GetString("y", &y_str);
+  code = jwk_fields.GetString("y", &y_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksECKeyMissingY;
   }
@@ -237,16 +384,42 @@ Status extractJwkFromJwkEC(const ::google::protobuf::Struct& jwk_pb,
   return e.getStatus();
 }
 
-Status extractJwkFromJwkOct(const ::google::protobuf::Struct& jwk_pb,
+// Creates an HMAC context keyed with key, nullptr on failure.
+bssl::UniquePtr<HMAC_CTX> createHmacTemplate(const std::string& key,
+                                             const EVP_MD* md) {
+  bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+  if (ctx == nullptr ||
+      HMAC_Init_ex(ctx.get(), key.data(), key.length(), md, nullptr) != 1) {
+    ERR_clear_error();
+    return nullptr;
+  }
+  return ctx;
+}
+
+// Keys the HMAC for the digests jwk can be used with, so that the inner and
+// outer padded keys are hashed only once.
+void createHmacTemplates(Jwks::Pubkey* jwk) {
+  const bool any_alg = jwk->alg_.empty();
+  if (any_alg || jwk->alg_ == "HS256") {
+    jwk->hmac_sha256_ = createHmacTemplate(jwk->hmac_key_, EVP_sha256());
+  }
+  if (any_alg || jwk->alg_ == "HS384") {
+    jwk->hmac_sha384_ = createHmacTemplate(jwk->hmac_key_, EVP_sha384());
+  }
+  if (any_alg || jwk->alg_ == "HS512") {
+    jwk->hmac_sha512_ = createHmacTemplate(jwk->hmac_key_, EVP_sha512());
+  }
+}
+
+Status extractJwkFromJwkOct(const JwkFields& jwk_fields,
                             Jwks::Pubkey* jwk) {
-  if (!jwk->alg_.empty() && jwk->alg_ != "HS256" && jwk->alg_ != "HS384" &&
-      jwk->alg_ != "HS512") {
-    return Status::JwksHMACKeyBadAlg;
+  Status status = checkOctKeyAlg(*jwk);
+  if (status != Status::Ok) {
+    return status;
   }
 
-  StructUtils jwk_getter(jwk_pb);
   std::string k_str;
-  auto code = jwk_getter.GetString("k", &k_str);
+  auto code = jwk_fields.GetString("k", &k_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksHMACKeyMissingK;
   }
@@ -255,26 +428,26 @@ Status extractJwkFromJwkOct(const ::google::protobuf::Struct& jwk_pb,
   }
 
   std::string key;
-  if (!absl::WebSafeBase64Unescape(k_str, &key) || key.empty()) {
+  if (!base64UrlDecode(k_str, &key) || key.empty()) {
     return Status::JwksOctBadBase64;
   }
 
   jwk->hmac_key_ = key;
+  createHmacTemplates(jwk);
   return Status::Ok;
 }
 
 // The "OKP" key type is defined in https://tools.ietf.org/html/rfc8037
-Status extractJwkFromJwkOKP(const ::google::protobuf::Struct& jwk_pb,
+Status extractJwkFromJwkOKP(const JwkFields& jwk_fields,
                             Jwks::Pubkey* jwk) {
-  // alg is not required, but if present it must be EdDSA
-  if (!jwk->alg_.empty() && jwk->alg_ != "EdDSA") {
-    return Status::JwksOKPKeyBadAlg;
+  Status status = checkOkpKeyAlg(*jwk);
+  if (status != Status::Ok) {
+    return status;
   }
 
   // crv is required per https://tools.ietf.org/html/rfc8037#section-2
-  StructUtils jwk_getter(jwk_pb);
   std::string crv_str;
-  auto code = jwk_getter.GetString("crv", &crv_str);
+  auto code = jwk_fields.GetString("crv", &crv_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksOKPKeyMissingCrv;
   }
@@ -301,7 +474,7 @@ Status extractJwkFromJwkOKP(const ::google::protobuf::Struct& jwk_pb,
 
   // x is required per https://tools.ietf.org/html/rfc8037#section-2
   std::string x_str;
-  code = jwk_getter.GetString("x", &x_str);
+  code = jwk_fields.GetString("x", &x_str);
   if (code == StructUtils::MISSING) {
     return Status::JwksOKPKeyMissingX;
   }
@@ -314,11 +487,10 @@ Status extractJwkFromJwkOKP(const ::google::protobuf::Struct& jwk_pb,
   return e.getStatus();
 }
 
-Status extractJwk(const ::google::protobuf::Struct& jwk_pb, Jwks::Pubkey* jwk) {
-  StructUtils jwk_getter(jwk_pb);
+Status extractJwk(const JwkFields& jwk_fields, Jwks::Pubkey* jwk) {
   // Check "kty" parameter, it should exist.
   // https://tools.ietf.org/html/rfc7517#section-4.1
-  auto code = jwk_getter.GetString("kty", &jwk->kty_);
+  auto code = jwk_fields.GetString("kty", &jwk->kty_);
   if (code == StructUtils::MISSING) {
     return Status::JwksMissingKty;
   }
@@ -328,23 +500,104 @@ Status extractJwk(const ::google::protobuf::Struct& jwk_pb, Jwks::Pubkey* jwk) {
 
   // "kid" and "alg" are optional, if they do not exist, set them to
   // empty. https://tools.ietf.org/html/rfc7517#page-8
-  jwk_getter.GetString("kid", &jwk->kid_);
-  jwk_getter.GetString("alg", &jwk->alg_);
+  jwk_fields.GetString("kid", &jwk->kid_);
+  jwk_fields.GetString("alg", &jwk->alg_);
 
   // Extract public key according to "kty" value.
   // https://tools.ietf.org/html/rfc7518#section-6.1
   if (jwk->kty_ == "EC") {
-    return extractJwkFromJwkEC(jwk_pb, jwk);
+    return extractJwkFromJwkEC(jwk_fields, jwk);
   } else if (jwk->kty_ == "RSA") {
-    return extractJwkFromJwkRSA(jwk_pb, jwk);
+    return extractJwkFromJwkRSA(jwk_fields, jwk);
   } else if (jwk->kty_ == "oct") {
-    return extractJwkFromJwkOct(jwk_pb, jwk);
+    return extractJwkFromJwkOct(jwk_fields, jwk);
   } else if (jwk->kty_ == "OKP") {
-    return extractJwkFromJwkOKP(jwk_pb, jwk);
+    return extractJwkFromJwkOKP(jwk_fields, jwk);
   }
   return Status::JwksNotImplementedKty;
 }
 
+// Keys of a previous keyset by fingerprint, to be reused.
+typedef absl::flat_hash_map<std::string, const Jwks::Pubkey*> KeysByFingerprint;
+
+void updateFingerprint(SHA256_CTX* ctx, uint8_t tag, const std::string& value) {
+  const uint64_t length = value.length();
+  SHA256_Update(ctx, &tag, sizeof(tag));
+  SHA256_Update(ctx, &length, sizeof(length));
+  SHA256_Update(ctx, value.data(), value.length());
+}
+
+std::string finalFingerprint(SHA256_CTX* ctx) {
+  uint8_t digest[SHA256_DIGEST_LENGTH];
+  SHA256_Final(digest, ctx);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+// Computes a digest of the fields a key is extracted from, so that JWKs with
+// the same fingerprint give the same key and the same status.
+std::string fingerprintJwk(const JwkFields& jwk_fields) {
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  for (const char* name : kJwkFields) {
+    std::string value;
+    const auto code = jwk_fields.GetString(name, &value);
+    updateFingerprint(&ctx, static_cast<uint8_t>(code), value);
+  }
+  return finalFingerprint(&ctx);
+}
+
+std::string fingerprintX509(const std::string& kid, const std::string& cert) {
+  SHA256_CTX ctx;
+  SHA256_Init(&ctx);
+  // Tagged apart from the StructUtils::FindResult values of fingerprintJwk.
+  updateFingerprint(&ctx, 0xff, kid);
+  updateFingerprint(&ctx, 0xff, cert);
+  return finalFingerprint(&ctx);
+}
+
+// Copies a key built by a previous keyset. The OpenSSL objects are not
+// modified after the key is built, so they are shared.
+Jwks::PubkeyPtr shareKey(const Jwks::Pubkey& jwk) {
+  Jwks::PubkeyPtr key_ptr(new Jwks::Pubkey());
+  key_ptr->hmac_key_ = jwk.hmac_key_;
+  key_ptr->kid_ = jwk.kid_;
+  key_ptr->kty_ = jwk.kty_;
+  key_ptr->alg_ = jwk.alg_;
+  key_ptr->crv_ = jwk.crv_;
+  if (jwk.rsa_ != nullptr && RSA_up_ref(jwk.rsa_.get())) {
+    key_ptr->rsa_.reset(jwk.rsa_.get());
+  }
+  if (jwk.ec_key_ != nullptr && EC_KEY_up_ref(jwk.ec_key_.get())) {
+    key_ptr->ec_key_.reset(jwk.ec_key_.get());
+  }
+  key_ptr->okp_key_raw_ = jwk.okp_key_raw_;
+  if (jwk.bio_ != nullptr && BIO_up_ref(jwk.bio_.get())) {
+    key_ptr->bio_.reset(jwk.bio_.get());
+  }
+  if (jwk.x509_ != nullptr && X509_up_ref(jwk.x509_.get())) {
+    key_ptr->x509_.reset(jwk.x509_.get());
+  }
+  if (jwk.evp_pkey_ != nullptr && EVP_PKEY_up_ref(jwk.evp_pkey_.get())) {
+    key_ptr->evp_pkey_.reset(jwk.evp_pkey_.get());
+  }
+  // The HMAC contexts are copied, which doesn't hash the key again.
+  bssl::UniquePtr<HMAC_CTX> Jwks::Pubkey::*const hmac_templates[] = {
+      &Jwks::Pubkey::hmac_sha256_, &Jwks::Pubkey::hmac_sha384_,
+      &Jwks::Pubkey::hmac_sha512_};
+  for (auto hmac_template : hmac_templates) {
+    if (jwk.*hmac_template == nullptr) {
+      continue;
+    }
+    bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+    if (ctx != nullptr &&
+        HMAC_CTX_copy_ex(ctx.get(), (jwk.*hmac_template).get()) == 1) {
+      (*key_ptr).*hmac_template = std::move(ctx);
+    }
+  }
+  key_ptr->fingerprint_ = jwk.fingerprint_;
+  return key_ptr;
+}
+
 Status extractX509(const std::string& key, Jwks::Pubkey* jwk) {
   jwk->bio_.reset(BIO_new(BIO_s_mem()));
   if (BIO_write(jwk->bio_.get(), key.c_str(), key.length()) <= 0) {
@@ -366,41 +619,299 @@ Status extractX509(const std::string& key, Jwks::Pubkey* jwk) {
   return Status::Ok;
 }
 
-bool shouldCheckX509(const ::google::protobuf::Struct& jwks_pb) {
-  if (jwks_pb.fields().empty()) {
-    return false;
-  }
+// Returns true if a top level field of a JWKS without "keys" is an X509
+// certificate, keyed by its kid.
+bool isX509Field(absl::string_view kid, JsonScanner::Token token,
+                 absl::string_view cert) {
+  return !kid.empty() && token == JsonScanner::String &&
+         absl::StartsWith(cert, kX509CertPrefix) &&
+         absl::EndsWith(cert, kX509CertSuffix);
+}
 
-  for (const auto& kid : jwks_pb.fields()) {
-    if (kid.first.empty() ||
-        kid.second.kind_case() != google::protobuf::Value::kStringValue) {
-      return false;
-    }
-    const std::string& cert = kid.second.string_value();
-    if (!absl::StartsWith(cert, kX509CertPrefix) ||
-        !absl::EndsWith(cert, kX509CertSuffix)) {
-      return false;
+Status createFromX509(
+    const std::vector<std::pair<std::string, std::string>>& certs,
+    const KeysByFingerprint& previous_keys,
+    std::vector<Jwks::PubkeyPtr>& keys) {
+  for (const auto& kid : certs) {
+    const std::string& cert = kid.second;
+    std::string fingerprint = fingerprintX509(kid.first, cert);
+    const auto previous_it = previous_keys.find(fingerprint);
+    if (previous_it != previous_keys.end()) {
+      keys.push_back(shareKey(*previous_it->second));
+      continue;
     }
-  }
-  return true;
-}
 
-Status createFromX509(const ::google::protobuf::Struct& jwks_pb,
-                      std::vector<Jwks::PubkeyPtr>& keys) {
-  for (const auto& kid : jwks_pb.fields()) {
     Jwks::PubkeyPtr key_ptr(new Jwks::Pubkey());
-    Status status = extractX509(kid.second.string_value(), key_ptr.get());
+    Status status = extractX509(cert, key_ptr.get());
     if (status != Status::Ok) {
       return status;
     }
 
     key_ptr->kid_ = kid.first;
     key_ptr->kty_ = "RSA";
+    key_ptr->fingerprint_ = std::move(fingerprint);
     keys.push_back(std::move(key_ptr));
   }
   return Status::Ok;
 }
 
+// Sets the fields of jwk precomputed for verification.
+void prepareKey(Jwks::Pubkey* jwk) {
+  jwk->algorithm_ = Jwks::algorithmFromString(jwk->alg_);
+
+  if (jwk->kty_ == "RSA") {
+    jwk->key_type_ = Jwks::KeyType::RSA;
+  } else if (jwk->kty_ == "EC") {
+    jwk->key_type_ = Jwks::KeyType::EC;
+  } else if (jwk->kty_ == "oct") {
+    jwk->key_type_ = Jwks::KeyType::Oct;
+  } else if (jwk->kty_ == "OKP" && jwk->crv_ == "Ed25519") {
+    jwk->key_type_ = Jwks::KeyType::OKP;
+  } else {
+    jwk->key_type_ = Jwks::KeyType::Unknown;
+  }
+
+  if (jwk->ec_key_ != nullptr) {
+    const EC_GROUP* group = EC_KEY_get0_group(jwk->ec_key_.get());
+    jwk->ec_signature_len_ =
+        group == nullptr ? 0 : 2 * ((EC_GROUP_get_degree(group) + 7) / 8);
+  }
+
+  if (jwk->evp_pkey_ != nullptr) {
+    return;
+  }
+  bssl::UniquePtr<EVP_PKEY> evp_pkey(EVP_PKEY_new());
+  if (jwk->rsa_ != nullptr &&
+      EVP_PKEY_set1_RSA(evp_pkey.get(), jwk->rsa_.get()) == 1) {
+    jwk->evp_pkey_ = std::move(evp_pkey);
+  } else if (jwk->ec_key_ != nullptr &&
+             EVP_PKEY_set1_EC_KEY(evp_pkey.get(), jwk->ec_key_.get()) == 1) {
+    jwk->evp_pkey_ = std::move(evp_pkey);
+  }
+}
+
+// The binary format of a keyset, see binary_utils.h for the encodings:
+//   keyset: "JWKB" version:u32 key_count:u32 key*
+//   key:    kind:u8 kid kty alg crv fingerprint material
+//   RSA:    n e
+//   EC:     curve_nid:u32 x y
+//   oct:    hmac_key
+//   OKP:    okp_key_raw
+// n, e, x and y are big-endian unsigned integers written as strings.
+const char kBinaryMagic[] = {'J', 'W', 'K', 'B'};
+const uint32_t kBinaryVersion = 1;
+
+enum class BinaryKeyKind : uint8_t { RSA = 1, EC = 2, Oct = 3, OKP = 4 };
+
+void appendBigNum(const BIGNUM* bn, std::string* out) {
+  std::string bytes(BN_num_bytes(bn), '\0');
+  BN_bn2bin(bn, reinterpret_cast<uint8_t*>(&bytes[0]));
+  appendBytes(bytes, out);
+}
+
+// Appends jwk in the binary format, false if its key can't be exported.
+bool appendKeyBinary(const Jwks::Pubkey& jwk, std::string* out) {
+  std::string material;
+  BinaryKeyKind kind;
+  if (jwk.rsa_ != nullptr) {
+    const BIGNUM* n = nullptr;
+    const BIGNUM* e = nullptr;
+    RSA_get0_key(jwk.rsa_.get(), &n, &e, nullptr);
+    if (n == nullptr || e == nullptr) {
+      return false;
+    }
+    kind = BinaryKeyKind::RSA;
+    appendBigNum(n, &material);
+    appendBigNum(e, &material);
+  } else if (jwk.ec_key_ != nullptr) {
+    const EC_GROUP* group = EC_KEY_get0_group(jwk.ec_key_.get());
+    const EC_POINT* point = EC_KEY_get0_public_key(jwk.ec_key_.get());
+    bssl::UniquePtr<BIGNUM> x(BN_new());
+    bssl::UniquePtr<BIGNUM> y(BN_new());
+    if (group == nullptr || point == nullptr || x == nullptr || y == nullptr ||
+        EC_POINT_get_affine_coordinates_GFp(group, point, x.get(), y.get(),
+                                            nullptr) == 0) {
+      ERR_clear_error();
+      return false;
+    }
+    kind = BinaryKeyKind::EC;
+    appendUInt32(EC_GROUP_get_curve_name(group), &material);
+    appendBigNum(x.get(), &material);
+    appendBigNum(y.get(), &material);
+  } else if (!jwk.hmac_key_.empty()) {
+    kind = BinaryKeyKind::Oct;
+    appendBytes(jwk.hmac_key_, &material);
+  } else if (!jwk.okp_key_raw_.empty()) {
+    kind = BinaryKeyKind::OKP;
+    appendBytes(jwk.okp_key_raw_, &material);
+  } else {
+    return false;
+  }
+
+  out->push_back(static_cast<char>(kind));
+  appendBytes(jwk.kid_, out);
+  appendBytes(jwk.kty_, out);
+  appendBytes(jwk.alg_, out);
+  appendBytes(jwk.crv_, out);
+  appendBytes(jwk.fingerprint_, out);
+  out->append(material);
+  return true;
+}
+
+bssl::UniquePtr<BIGNUM> readBigNum(BinaryReader& reader) {
+  absl::string_view bytes;
+  if (!reader.readString(&bytes)) {
+    return nullptr;
+  }
+  return bssl::UniquePtr<BIGNUM>(BN_bin2bn(
+      reinterpret_cast<const uint8_t*>(bytes.data()), bytes.length(), NULL));
+}
+
+// The kty of the keys of a binary kind, nullptr for an unknown kind.
+const char* binaryKeyKty(BinaryKeyKind kind) {
+  switch (kind) {
+    case BinaryKeyKind::RSA:
+      return "RSA";
+    case BinaryKeyKind::EC:
+      return "EC";
+    case BinaryKeyKind::Oct:
+      return "oct";
+    case BinaryKeyKind::OKP:
+      return "OKP";
+  }
+  return nullptr;
+}
+
+// The crv of the keys of an EC curve, nullptr for an unsupported curve.
+const char* ecCurveName(uint32_t nid) {
+  switch (nid) {
+    case NID_X9_62_prime256v1:
+      return "P-256";
+    case NID_secp384r1:
+      return "P-384";
+    case NID_secp521r1:
+      return "P-521";
+  }
+  return nullptr;
+}
+
+// Reads a key written by appendKeyBinary, with the same checks as the
+// extraction of a JWK with this key material.
+Status readKeyBinary(BinaryReader& reader, Jwks::Pubkey* jwk) {
+  uint8_t kind;
+  if (!reader.readUInt8(&kind) || !reader.readString(&jwk->kid_) ||
+      !reader.readString(&jwk->kty_) || !reader.readString(&jwk->alg_) ||
+      !reader.readString(&jwk->crv_) ||
+      !reader.readString(&jwk->fingerprint_)) {
+    return Status::JwksBinaryParseError;
+  }
+  // The key type is derived from kty_, it must be the type of the material.
+  const char* kty = binaryKeyKty(static_cast<BinaryKeyKind>(kind));
+  if (kty == nullptr || jwk->kty_ != kty) {
+    return Status::JwksBinaryParseError;
+  }
+
+  switch (static_cast<BinaryKeyKind>(kind)) {
+    case BinaryKeyKind::RSA: {
+      Status status = checkRsaKeyAlg(*jwk);
+      if (status != Status::Ok) {
+        return status;
+      }
+      bssl::UniquePtr<BIGNUM> n = readBigNum(reader);
+      bssl::UniquePtr<BIGNUM> e = readBigNum(reader);
+      if (n == nullptr || e == nullptr) {
+        return Status::JwksBinaryParseError;
+      }
+      if (BN_cmp_word(e.get(), 3) != 0 && BN_cmp_word(e.get(), 65537) != 0) {
+        return Status::JwksRsaParseError;
+      }
+      jwk->rsa_.reset(RSA_new());
+      if (jwk->rsa_ == nullptr ||
+          RSA_set0_key(jwk->rsa_.get(), n.get(), e.get(), nullptr) == 0) {
+        return Status::JwksRsaParseError;
+      }
+      n.release();
+      e.release();
+      return Status::Ok;
+    }
+    case BinaryKeyKind::EC: {
+      uint32_t nid;
+      if (!reader.readUInt32(&nid)) {
+        return Status::JwksBinaryParseError;
+      }
+      bssl::UniquePtr<BIGNUM> x = readBigNum(reader);
+      bssl::UniquePtr<BIGNUM> y = readBigNum(reader);
+      if (x == nullptr || y == nullptr) {
+        return Status::JwksBinaryParseError;
+      }
+      const char* crv = ecCurveName(nid);
+      if (crv == nullptr) {
+        return Status::JwksEcCreateKeyFail;
+      }
+      // The crv was set from the curve when the JWK was extracted.
+      if (jwk->crv_ != crv) {
+        return Status::JwksECKeyAlgNotCompatibleWithCrv;
+      }
+      Status status = checkEcKeyAlg(*jwk);
+      if (status == Status::Ok) {
+        status = checkEcKeyAlgAndCrv(*jwk);
+      }
+      if (status != Status::Ok) {
+        return status;
+      }
+      jwk->ec_key_.reset(EC_KEY_new_by_curve_name(nid));
+      if (jwk->ec_key_ == nullptr) {
+        return Status::JwksEcCreateKeyFail;
+      }
+      if (EC_KEY_set_public_key_affine_coordinates(jwk->ec_key_.get(), x.get(),
+                                                   y.get()) == 0) {
+        ERR_clear_error();
+        return Status::JwksEcParseError;
+      }
+      return Status::Ok;
+    }
+    case BinaryKeyKind::Oct: {
+      Status status = checkOctKeyAlg(*jwk);
+      if (status != Status::Ok) {
+        return status;
+      }
+      if (!reader.readString(&jwk->hmac_key_)) {
+        return Status::JwksBinaryParseError;
+      }
+      if (jwk->hmac_key_.empty()) {
+        return Status::JwksOctBadBase64;
+      }
+      createHmacTemplates(jwk);
+      return Status::Ok;
+    }
+    case BinaryKeyKind::OKP: {
+      Status status = checkOkpKeyAlg(*jwk);
+      if (status != Status::Ok) {
+        return status;
+      }
+      if (jwk->crv_ != "Ed25519") {
+        return Status::JwksOKPKeyCrvUnsupported;
+      }
+      if (!reader.readString(&jwk->okp_key_raw_)) {
+        return Status::JwksBinaryParseError;
+      }
+      if (jwk->okp_key_raw_.length() != ED25519_PUBLIC_KEY_LEN) {
+        return Status::JwksOKPXWrongLength;
+      }
+      return Status::Ok;
+    }
+  }
+  return Status::JwksBinaryParseError;
+}
+
+// The hash of the key hint slots.
+uint64_t keyHintHash(absl::string_view iss, absl::string_view kid,
+                     absl::string_view alg) {
+  return absl::Hash<std::tuple<absl::string_view, absl::string_view,
+                               absl::string_view>>()(
+      std::make_tuple(iss, kid, alg));
+}
+
 }  // namespace
 
 Status Jwks::addKeyFromPem(const std::string& pkey, const std::string& kid,
@@ -411,9 +922,106 @@ Status Jwks::addKeyFromPem(const std::string& pkey, const std::string& kid,
   }
   keys_.insert(keys_.end(), std::make_move_iterator(tmp->keys_.begin()),
                std::make_move_iterator(tmp->keys_.end()));
+  prepareKeys();
   return Status::Ok;
 }
 
+const std::vector<const Jwks::Pubkey*>& Jwks::keysForKid(
+    absl::string_view kid) const {
+  if (kid.empty()) {
+    return all_keys_;
+  }
+  const auto it = kid_index_.find(kid);
+  if (it == kid_index_.end()) {
+    return kidless_keys_;
+  }
+  return it->second;
+}
+
+Jwks::Algorithm Jwks::algorithmFromString(absl::string_view alg) {
+  static const absl::flat_hash_map<absl::string_view, Algorithm>* algorithms =
+      new absl::flat_hash_map<absl::string_view, Algorithm>({
+          {"RS256", Algorithm::RS256},
+          {"RS384", Algorithm::RS384},
+          {"RS512", Algorithm::RS512},
+          {"PS256", Algorithm::PS256},
+          {"PS384", Algorithm::PS384},
+          {"PS512", Algorithm::PS512},
+          {"ES256", Algorithm::ES256},
+          {"ES384", Algorithm::ES384},
+          {"ES512", Algorithm::ES512},
+          {"HS256", Algorithm::HS256},
+          {"HS384", Algorithm::HS384},
+          {"HS512", Algorithm::HS512},
+          {"EdDSA", Algorithm::EdDSA},
+      });
+  if (alg.empty()) {
+    return Algorithm::None;
+  }
+  const auto it = algorithms->find(alg);
+  return it == algorithms->end() ? Algorithm::Unknown : it->second;
+}
+
+void Jwks::prepareKeys() {
+  // Starts at 1 so that a generation is never 0.
+  static std::atomic<uint64_t> next_generation(1);
+  generation_ = next_generation.fetch_add(1, std::memory_order_relaxed);
+
+  for (auto& hint : key_hints_) {
+    hint.store(0, std::memory_order_relaxed);
+  }
+
+  all_keys_.clear();
+  kidless_keys_.clear();
+  kid_index_.clear();
+  for (const auto& key : keys_) {
+    prepareKey(key.get());
+    all_keys_.push_back(key.get());
+    if (key->kid_.empty()) {
+      // A key without kid is a candidate for every kid.
+      kidless_keys_.push_back(key.get());
+      for (auto& entry : kid_index_) {
+        entry.second.push_back(key.get());
+      }
+    } else {
+      auto it = kid_index_.find(key->kid_);
+      if (it == kid_index_.end()) {
+        // Kidless keys seen so far come before this key.
+        it = kid_index_.emplace(key->kid_, kidless_keys_).first;
+      }
+      it->second.push_back(key.get());
+    }
+  }
+}
+
+constexpr size_t Jwks::kNoKeyHint;
+constexpr size_t Jwks::kKeyHintSlots;
+
+size_t Jwks::keyHint(absl::string_view iss, absl::string_view kid,
+                     absl::string_view alg) const {
+  const uint64_t hash = keyHintHash(iss, kid, alg);
+  const uint64_t hint =
+      key_hints_[hash % kKeyHintSlots].load(std::memory_order_relaxed);
+  if ((hint >> 32) != (hash >> 32) || (hint & 0xffffffff) == 0) {
+    return kNoKeyHint;
+  }
+  return (hint & 0xffffffff) - 1;
+}
+
+void Jwks::setKeyHint(absl::string_view iss, absl::string_view kid,
+                      absl::string_view alg, size_t index) const {
+  if (index >= 0xffffffff) {
+    return;
+  }
+  const uint64_t hash = keyHintHash(iss, kid, alg);
+  const uint64_t hint = (hash & 0xffffffff00000000) | (index + 1);
+  std::atomic<uint64_t>& slot = key_hints_[hash % kKeyHintSlots];
+  // Skip the store, and the cache line invalidation, when unchanged.
+  if (slot.load(std::memory_order_relaxed) != hint) {
+    slot.store(hint, std::memory_order_relaxed);
+  }
+}
+
 JwksPtr Jwks::createFrom(const std::string& pkey, Type type) {
   JwksPtr keys(new Jwks());
   switch (type) {
@@ -424,9 +1032,40 @@ JwksPtr Jwks::createFrom(const std::string& pkey, Type type) {
       keys->createFromPemCore(pkey);
       break;
   }
+  keys->prepareKeys();
+  return keys;
+}
+
+JwksPtr Jwks::updateFrom(const Jwks& previous, const std::string& pkey_jwks) {
+  JwksPtr keys(new Jwks());
+  keys->createFromJwksCore(pkey_jwks, &previous);
+  keys->prepareKeys();
   return keys;
 }
 
+JwksPtr Jwks::createFromBinary(absl::string_view data) {
+  JwksPtr keys(new Jwks());
+  keys->createFromBinaryCore(data);
+  keys->prepareKeys();
+  return keys;
+}
+
+std::string Jwks::serializeBinary() const {
+  std::string keys;
+  uint32_t key_count = 0;
+  for (const auto& key : keys_) {
+    if (appendKeyBinary(*key, &keys)) {
+      ++key_count;
+    }
+  }
+
+  std::string out(kBinaryMagic, sizeof(kBinaryMagic));
+  appendUInt32(kBinaryVersion, &out);
+  appendUInt32(key_count, &out);
+  out.append(keys);
+  return out;
+}
+
 JwksPtr Jwks::createFromPem(const std::string& pkey, const std::string& kid,
                             const std::string& alg) {
   std::unique_ptr<Jwks> ret = Jwks::createFrom(pkey, Jwks::PEM);
@@ -451,6 +1090,7 @@ JwksPtr Jwks::createFromPem(const std::string& pkey, const std::string& kid,
   if (jwk->alg_ == "ES512") {
     jwk->crv_ = "P-521";
   }
+  ret->prepareKeys();
   return ret;
 }
 
@@ -502,52 +1142,160 @@ void Jwks::createFromPemCore(const std::string& pkey_pem) {
   keys_.push_back(std::move(key_ptr));
 }
 
-void Jwks::createFromJwksCore(const std::string& jwks_json) {
+void Jwks::createFromJwksCore(const std::string& jwks_json,
+                              const Jwks* previous) {
   keys_.clear();
 
-  ::google::protobuf::util::JsonParseOptions options;
-  ::google::protobuf::Struct jwks_pb;
-  const auto status = ::google::protobuf::util::JsonStringToMessage(
-      jwks_json, &jwks_pb, options);
-  if (!status.ok()) {
+  KeysByFingerprint previous_keys;
+  if (previous != nullptr) {
+    for (const auto& key : previous->keys_) {
+      if (!key->fingerprint_.empty()) {
+        previous_keys.emplace(key->fingerprint_, key.get());
+      }
+    }
+  }
+
+  // The document is scanned once and each key is extracted as soon as its
+  // object is read, so no Struct of the whole document is built. The status
+  // is only set at the end, a parse error anywhere takes precedence.
+  JsonScanner scanner(jwks_json);
+  bool valid = scanner.next() == JsonScanner::BeginObject;
+  bool has_keys = false;
+  bool keys_is_list = false;
+  Status first_key_error = Status::Ok;
+  // The top level fields, while they may all be X509 certificates.
+  bool maybe_x509 = true;
+  std::vector<std::pair<std::string, std::string>> x509_certs;
+  JwkFields jwk_fields;
+
+  while (valid) {
+    JsonScanner::Token token = scanner.next();
+    if (token == JsonScanner::EndObject) {
+      valid = scanner.next() == JsonScanner::End;
+      break;
+    }
+    if (token != JsonScanner::Key) {
+      valid = false;
+      break;
+    }
+
+    if (scanner.str() != "keys") {
+      std::string kid(scanner.str());
+      token = scanner.next();
+      if (maybe_x509 && isX509Field(kid, token, scanner.str())) {
+        x509_certs.emplace_back(std::move(kid), std::string(scanner.str()));
+        continue;
+      }
+      maybe_x509 = false;
+      x509_certs.clear();
+      valid = scanner.skipValue(token);
+      continue;
+    }
+
+    has_keys = true;
+    maybe_x509 = false;
+    x509_certs.clear();
+    token = scanner.next();
+    if (token != JsonScanner::BeginArray) {
+      valid = scanner.skipValue(token);
+      continue;
+    }
+    keys_is_list = true;
+    for (token = scanner.next(); valid && token != JsonScanner::EndArray;
+         token = scanner.next()) {
+      if (token != JsonScanner::BeginObject) {
+        valid = scanner.skipValue(token);
+        continue;
+      }
+      if (!jwk_fields.read(&scanner)) {
+        valid = false;
+        break;
+      }
+
+      std::string fingerprint = fingerprintJwk(jwk_fields);
+      const auto previous_it = previous_keys.find(fingerprint);
+      if (previous_it != previous_keys.end()) {
+        keys_.push_back(shareKey(*previous_it->second));
+        continue;
+      }
+
+      PubkeyPtr key_ptr(new Pubkey());
+      Status status = extractJwk(jwk_fields, key_ptr.get());
+      key_ptr->fingerprint_ = std::move(fingerprint);
+      if (status == Status::Ok) {
+        keys_.push_back(std::move(key_ptr));
+      } else if (first_key_error == Status::Ok) {
+        first_key_error = status;
+      }
+    }
+  }
+
+  if (!valid) {
+    keys_.clear();
     updateStatus(Status::JwksParseError);
     return;
   }
-
-  const auto& fields = jwks_pb.fields();
-  const auto keys_it = fields.find("keys");
-  if (keys_it == fields.end()) {
+  if (!has_keys) {
     // X509 doesn't have "keys" field.
-    if (shouldCheckX509(jwks_pb)) {
-      updateStatus(createFromX509(jwks_pb, keys_));
+    if (maybe_x509 && !x509_certs.empty()) {
+      updateStatus(createFromX509(x509_certs, previous_keys, keys_));
       return;
     }
     updateStatus(Status::JwksNoKeys);
     return;
   }
-  if (keys_it->second.kind_case() != google::protobuf::Value::kListValue) {
+  if (!keys_is_list) {
     updateStatus(Status::JwksBadKeys);
     return;
   }
 
-  for (const auto& key_value : keys_it->second.list_value().values()) {
-    if (key_value.kind_case() != ::google::protobuf::Value::kStructValue) {
-      continue;
-    }
+  if (keys_.empty()) {
+    updateStatus(first_key_error != Status::Ok ? first_key_error
+                                               : Status::JwksNoValidKeys);
+  }
+}
+
+void Jwks::createFromBinaryCore(absl::string_view data) {
+  keys_.clear();
+
+  BinaryReader reader(data);
+  absl::string_view magic;
+  uint32_t version;
+  uint32_t key_count;
+  if (!reader.readBytes(sizeof(kBinaryMagic), &magic) ||
+      magic != absl::string_view(kBinaryMagic, sizeof(kBinaryMagic)) ||
+      !reader.readUInt32(&version)) {
+    updateStatus(Status::JwksBinaryParseError);
+    return;
+  }
+  if (version != kBinaryVersion) {
+    updateStatus(Status::JwksBinaryBadVersion);
+    return;
+  }
+  if (!reader.readUInt32(&key_count)) {
+    updateStatus(Status::JwksBinaryParseError);
+    return;
+  }
+
+  for (uint32_t i = 0; i < key_count; ++i) {
     PubkeyPtr key_ptr(new Pubkey());
-    Status status = extractJwk(key_value.struct_value(), key_ptr.get());
-    if (status == Status::Ok) {
-      keys_.push_back(std::move(key_ptr));
-      resetStatus(status);
-    } else {
+    Status status = readKeyBinary(reader, key_ptr.get());
+    if (status != Status::Ok) {
+      // The keyset was written by serializeBinary(), so it is all or none.
+      keys_.clear();
       updateStatus(status);
+      return;
     }
+    keys_.push_back(std::move(key_ptr));
+  }
+  if (!reader.empty()) {
+    keys_.clear();
+    updateStatus(Status::JwksBinaryParseError);
+    return;
   }
 
   if (keys_.empty()) {
     updateStatus(Status::JwksNoValidKeys);
-  } else {
-    resetStatus(Status::Ok);
   }
 }
 
@@ -0,0 +1,43 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/jwks_holder.h"
+
+#include <utility>
+
+namespace google {
+namespace jwt_verify {
+
+JwksHolder::JwksHolder(JwksSnapshot jwks) : jwks_(std::move(jwks)) {}
+
+JwksSnapshot JwksHolder::acquire() const { return std::atomic_load(&jwks_); }
+
+void JwksHolder::publish(JwksSnapshot jwks) {
+  std::atomic_store(&jwks_, std::move(jwks));
+}
+
+Status JwksHolder::refresh(const std::string& pkey_jwks) {
+  std::lock_guard<std::mutex> lock(refresh_mutex_);
+  const JwksSnapshot current = acquire();
+  JwksPtr jwks = current ? Jwks::updateFrom(*current, pkey_jwks)
+                         : Jwks::createFrom(pkey_jwks, Jwks::JWKS);
+  const Status status = jwks->getStatus();
+  if (status == Status::Ok) {
+    publish(std::move(jwks));
+  }
+  return status;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -0,0 +1,130 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/jwks_provider.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace google {
+namespace jwt_verify {
+
+JwksProvider::JwksProvider(Fetcher fetcher, Options options)
+    : fetcher_(std::move(fetcher)),
+      options_(std::move(options)),
+      thread_(&JwksProvider::run, this) {}
+
+JwksProvider::JwksProvider(Fetcher fetcher)
+    : JwksProvider(std::move(fetcher), Options()) {}
+
+JwksProvider::~JwksProvider() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeup_.notify_all();
+  thread_.join();
+}
+
+JwksSnapshot JwksProvider::acquireForKid(absl::string_view kid) {
+  JwksSnapshot jwks = acquire();
+  if (kid.empty() || !jwks) {
+    return jwks;
+  }
+  for (const Jwks::Pubkey* key : jwks->keysForKid(kid)) {
+    if (key->kid_ == kid) {
+      return jwks;
+    }
+  }
+  requestRefresh();
+  return jwks;
+}
+
+void JwksProvider::requestRefresh() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A refresh in progress may already have the new keys; if not, the next
+    // token with the unknown kid requests another one.
+    if (refreshing_ || refresh_requested_) {
+      return;
+    }
+    refresh_requested_ = true;
+  }
+  wakeup_.notify_one();
+}
+
+bool JwksProvider::waitForKeys(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return published_.wait_for(lock, timeout,
+                             [this] { return acquire() != nullptr; });
+}
+
+Status JwksProvider::lastStatus() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_status_;
+}
+
+void JwksProvider::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  bool first = true;
+  while (!stopping_) {
+    if (!first) {
+      // Retry sooner after a failure, and refresh early if requested.
+      auto next = last_refresh_ + (last_status_ == Status::Ok
+                                       ? options_.refresh_interval
+                                       : options_.min_refresh_interval);
+      if (refresh_requested_) {
+        next = std::min(next, last_refresh_ + options_.min_refresh_interval);
+      }
+      if (std::chrono::steady_clock::now() < next) {
+        wakeup_.wait_until(lock, next);
+        continue;
+      }
+    }
+    first = false;
+    refresh_requested_ = false;
+    refreshing_ = true;
+    lock.unlock();
+    const Status status = refresh();
+    lock.lock();
+    refreshing_ = false;
+    last_refresh_ = std::chrono::steady_clock::now();
+    last_status_ = status;
+    published_.notify_all();
+    if (options_.on_refresh) {
+      lock.unlock();
+      options_.on_refresh(status);
+      lock.lock();
+    }
+  }
+}
+
+Status JwksProvider::refresh() {
+  std::string pkey_jwks;
+  if (!fetcher_(&pkey_jwks)) {
+    return Status::JwksFetchError;
+  }
+  // Most refreshes return the same keyset, which doesn't need to be parsed.
+  if (pkey_jwks == last_jwks_ && acquire()) {
+    return Status::Ok;
+  }
+  const Status status = holder_.refresh(pkey_jwks);
+  if (status == Status::Ok) {
+    last_jwks_ = std::move(pkey_jwks);
+  }
+  return status;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
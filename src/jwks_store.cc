@@ -0,0 +1,168 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/jwks_store.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "jwt_verify_lib/binary_utils.h"
+
+namespace google {
+namespace jwt_verify {
+
+namespace {
+
+// The store format, see binary_utils.h for the encodings:
+//   store: "JWKS" version:u32 issuer_count:u32 (issuer keyset)*
+// where issuer and keyset are strings, keyset in the Jwks binary format.
+const char kStoreMagic[] = {'J', 'W', 'K', 'S'};
+const uint32_t kStoreVersion = 1;
+
+// The number of shards of the keyset cache.
+const size_t kNumShards = 16;
+
+}  // namespace
+
+JwksStore::JwksStore(size_t max_cached_issuers)
+    // Each shard holds at least one keyset.
+    : cache_(std::min(kNumShards, std::max<size_t>(max_cached_issuers, 1)),
+             max_cached_issuers) {}
+
+JwksStore::~JwksStore() {
+  // The cached keysets don't point into the mapping.
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_length_);
+  }
+}
+
+std::string JwksStore::serialize(
+    const std::map<std::string, const Jwks*>& keysets) {
+  std::string out(kStoreMagic, sizeof(kStoreMagic));
+  appendUInt32(kStoreVersion, &out);
+  appendUInt32(keysets.size(), &out);
+  for (const auto& keyset : keysets) {
+    appendBytes(keyset.first, &out);
+    appendBytes(keyset.second->serializeBinary(), &out);
+  }
+  return out;
+}
+
+std::unique_ptr<JwksStore> JwksStore::createFromFile(
+    const std::string& path, size_t max_cached_issuers) {
+  std::unique_ptr<JwksStore> store(new JwksStore(max_cached_issuers));
+  const int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    store->updateStatus(Status::JwksStoreOpenError);
+    return store;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    store->updateStatus(Status::JwksStoreOpenError);
+    return store;
+  }
+  void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file is closed.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    store->updateStatus(Status::JwksStoreOpenError);
+    return store;
+  }
+
+  store->mapping_ = mapping;
+  store->mapping_length_ = st.st_size;
+  store->data_ =
+      absl::string_view(static_cast<const char*>(mapping), st.st_size);
+  store->createIndex();
+  return store;
+}
+
+std::unique_ptr<JwksStore> JwksStore::createFromData(
+    absl::string_view data, size_t max_cached_issuers) {
+  std::unique_ptr<JwksStore> store(new JwksStore(max_cached_issuers));
+  store->data_ = data;
+  store->createIndex();
+  return store;
+}
+
+void JwksStore::createIndex() {
+  BinaryReader reader(data_);
+  absl::string_view magic;
+  uint32_t version;
+  uint32_t issuer_count;
+  if (!reader.readBytes(sizeof(kStoreMagic), &magic) ||
+      magic != absl::string_view(kStoreMagic, sizeof(kStoreMagic)) ||
+      !reader.readUInt32(&version)) {
+    updateStatus(Status::JwksBinaryParseError);
+    return;
+  }
+  if (version != kStoreVersion) {
+    updateStatus(Status::JwksBinaryBadVersion);
+    return;
+  }
+  if (!reader.readUInt32(&issuer_count)) {
+    updateStatus(Status::JwksBinaryParseError);
+    return;
+  }
+
+  // Only the lengths are read, the keysets are parsed by get(). The count
+  // isn't trusted before the entries are read, each one takes at least the
+  // lengths of its two strings.
+  index_.reserve(std::min<size_t>(issuer_count, reader.remaining() / 8));
+  for (uint32_t i = 0; i < issuer_count; ++i) {
+    absl::string_view issuer;
+    absl::string_view keyset;
+    if (!reader.readString(&issuer) || !reader.readString(&keyset)) {
+      index_.clear();
+      updateStatus(Status::JwksBinaryParseError);
+      return;
+    }
+    index_[issuer] = keyset;
+  }
+  if (!reader.empty()) {
+    index_.clear();
+    updateStatus(Status::JwksBinaryParseError);
+  }
+}
+
+JwksSnapshot JwksStore::get(absl::string_view issuer) {
+  const std::string key(issuer);
+  {
+    decltype(cache_)::ScopedLookup lookup(&cache_, key);
+    if (lookup.found()) {
+      return lookup.value()->jwks;
+    }
+  }
+
+  const auto it = index_.find(issuer);
+  if (it == index_.end()) {
+    return nullptr;
+  }
+  // Concurrent misses for the same issuer may both create the keyset, the
+  // last one inserted is kept.
+  JwksSnapshot jwks = Jwks::createFromBinary(it->second);
+  if (jwks->getStatus() != Status::Ok) {
+    return nullptr;
+  }
+  cache_.insert(key, new Entry{jwks}, 1);
+  return jwks;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
@@ -15,13 +15,16 @@
 #include "jwt_verify_lib/jwt.h"
 
 #include <algorithm>
+#include <memory>
 
 #include "absl/container/flat_hash_set.h"
-#include "absl/strings/escaping.h"
 #include "absl/strings/str_split.h"
 #include "absl/time/clock.h"
 #include "google/protobuf/util/json_util.h"
+#include "jwt_verify_lib/base64_utils.h"
+#include "jwt_verify_lib/json_scanner.h"
 #include "jwt_verify_lib/struct_utils.h"
+#include "jwt_verify_lib/verify_stats.h"
 
 namespace google {
 namespace jwt_verify {
@@ -38,124 +41,519 @@ bool isImplemented(absl::string_view alg) {
   return implemented_algs.find(alg) != implemented_algs.end();
 }
 
-}  // namespace
-
-Jwt::Jwt(const Jwt& instance) { *this = instance; }
+// Splits jwt into its dot separated sections, empty sections are skipped.
+// Returns false if jwt doesn't have exactly 3 sections.
+bool splitJwt(absl::string_view jwt, absl::string_view sections[3]) {
+  size_t count = 0;
+  for (absl::string_view section :
+       absl::StrSplit(jwt, '.', absl::SkipEmpty())) {
+    if (count == 3) {
+      return false;
+    }
+    sections[count++] = section;
+  }
+  return count == 3;
+}
 
-Jwt& Jwt::operator=(const Jwt& rhs) {
-  parseFromString(rhs.jwt_);
-  return *this;
+// Sets signed_data to the header, the dot and the payload of a split jwt.
+// Returns false if header and payload are not separated by a single dot, as
+// the signed data could then not be verified in place.
+bool getSignedData(const absl::string_view sections[3],
+                   absl::string_view* signed_data) {
+  if (sections[1].data() != sections[0].data() + sections[0].size() + 1) {
+    return false;
+  }
+  *signed_data = absl::string_view(
+      sections[0].data(), sections[0].size() + 1 + sections[1].size());
+  return true;
 }
 
-Status Jwt::parseFromString(const std::string& jwt) {
-  // jwt must have exactly 2 dots with 3 sections.
-  jwt_ = jwt;
-  std::vector<absl::string_view> jwt_split =
-      absl::StrSplit(jwt, '.', absl::SkipEmpty());
-  if (jwt_split.size() != 3) {
-    return Status::JwtBadFormat;
+// Collects the top level fields of a JSON object in one pass with
+// JsonScanner, without building a Struct. The getters return what StructUtils
+// would return for the same fields of the equivalent Struct.
+class ScannedFields {
+ public:
+  ScannedFields(std::initializer_list<absl::string_view> names) {
+    for (absl::string_view name : names) {
+      fields_[size_++].name = name;
+    }
   }
 
-  // Parse header json
-  header_str_base64url_ = std::string(jwt_split[0]);
-  if (!absl::WebSafeBase64Unescape(header_str_base64url_, &header_str_)) {
-    return Status::JwtHeaderParseErrorBadBase64;
+  // Returns false if json is not a valid Struct.
+  bool parse(absl::string_view json) {
+    JsonScanner scanner(json);
+    if (scanner.next() != JsonScanner::BeginObject) {
+      return false;
+    }
+    for (;;) {
+      JsonScanner::Token token = scanner.next();
+      if (token == JsonScanner::EndObject) {
+        return scanner.next() == JsonScanner::End;
+      }
+      if (token != JsonScanner::Key) {
+        return false;
+      }
+      Field* field = find(scanner.str());
+      token = scanner.next();
+      if (field == nullptr) {
+        if (!scanner.skipValue(token)) {
+          return false;
+        }
+      } else if (!readField(&scanner, token, field)) {
+        return false;
+      }
+    }
+  }
+
+  StructUtils::FindResult GetString(absl::string_view name,
+                                    std::string* value) {
+    const Field* field = find(name);
+    if (field->kind == Field::Missing) {
+      return StructUtils::MISSING;
+    }
+    if (field->kind != Field::String) {
+      return StructUtils::WRONG_TYPE;
+    }
+    *value = field->str;
+    return StructUtils::OK;
+  }
+
+  StructUtils::FindResult GetUInt64(absl::string_view name, uint64_t* value) {
+    const Field* field = find(name);
+    if (field->kind == Field::Missing) {
+      return StructUtils::MISSING;
+    }
+    if (field->kind != Field::Number) {
+      return StructUtils::WRONG_TYPE;
+    }
+    if (field->number < 0) {
+      return StructUtils::NOT_POSITIVE;
+    }
+    *value = static_cast<uint64_t>(field->number);
+    return StructUtils::OK;
   }
 
+  StructUtils::FindResult GetStringList(absl::string_view name,
+                                        std::vector<std::string>* list) {
+    const Field* field = find(name);
+    if (field->kind == Field::Missing) {
+      return StructUtils::MISSING;
+    }
+    if (field->kind == Field::String) {
+      list->push_back(field->str);
+      return StructUtils::OK;
+    }
+    if (field->kind == Field::StringList) {
+      list->insert(list->end(), field->list.begin(), field->list.end());
+      return StructUtils::OK;
+    }
+    return StructUtils::WRONG_TYPE;
+  }
+
+ private:
+  // Enough for the registered claims read by parsePayloadClaims.
+  static constexpr size_t kMaxFields = 7;
+
+  struct Field {
+    enum Kind { Missing, String, Number, StringList, Other };
+
+    absl::string_view name;
+    Kind kind = Missing;
+    std::string str;
+    double number = 0;
+    std::vector<std::string> list;
+  };
+
+  Field* find(absl::string_view name) {
+    for (size_t i = 0; i < size_; ++i) {
+      if (fields_[i].name == name) {
+        return &fields_[i];
+      }
+    }
+    return nullptr;
+  }
+
+  static bool readField(JsonScanner* scanner, JsonScanner::Token token,
+                        Field* field) {
+    switch (token) {
+      case JsonScanner::String:
+        field->kind = Field::String;
+        field->str = std::string(scanner->str());
+        return true;
+      case JsonScanner::Number:
+        field->kind = Field::Number;
+        field->number = scanner->number();
+        return true;
+      case JsonScanner::BeginArray:
+        field->kind = Field::StringList;
+        for (token = scanner->next(); token != JsonScanner::EndArray;
+             token = scanner->next()) {
+          if (token == JsonScanner::String) {
+            field->list.emplace_back(scanner->str());
+            continue;
+          }
+          field->kind = Field::Other;
+          if (!scanner->skipValue(token)) {
+            return false;
+          }
+        }
+        return true;
+      default:
+        field->kind = Field::Other;
+        return scanner->skipValue(token);
+    }
+  }
+
+  Field fields_[kMaxFields];
+  size_t size_ = 0;
+};
+
+// Returns the Struct cached in cache, parsing it from the json returned by
+// get_json on first access. The json was already accepted by ScannedFields,
+// the Struct is left empty if it is not valid. Concurrent first accesses may
+// parse the json more than once, but all of them get the same Struct.
+// The Struct is allocated on arena if not nullptr.
+template <typename GetJson>
+const ::google::protobuf::Struct& getOrParseStruct(
+    const SharedStruct& shared, ::google::protobuf::Arena* arena,
+    GetJson get_json) {
+  std::shared_ptr<const ::google::protobuf::Struct>* cache = &shared.pb;
+  std::shared_ptr<const ::google::protobuf::Struct> struct_pb =
+      std::atomic_load(cache);
+  if (struct_pb) {
+    return *struct_pb;
+  }
+
+  std::shared_ptr<::google::protobuf::Struct> parsed;
+  if (arena == nullptr) {
+    parsed = std::make_shared<::google::protobuf::Struct>();
+  } else {
+    // Freed with the arena.
+    parsed.reset(
+        ::google::protobuf::Arena::CreateMessage<::google::protobuf::Struct>(
+            arena),
+        [](::google::protobuf::Struct*) {});
+  }
   ::google::protobuf::util::JsonParseOptions options;
-  const auto header_status = ::google::protobuf::util::JsonStringToMessage(
-      header_str_, &header_pb_, options);
-  if (!header_status.ok()) {
-    return Status::JwtHeaderParseErrorBadJson;
+  if (!::google::protobuf::util::JsonStringToMessage(get_json(), parsed.get(),
+                                                     options)
+           .ok()) {
+    parsed->Clear();
+  }
+  std::shared_ptr<const ::google::protobuf::Struct> desired = parsed;
+  if (std::atomic_compare_exchange_strong(cache, &struct_pb, desired)) {
+    struct_pb = std::move(desired);
   }
+  return *struct_pb;
+}
+
+// Clears the fields read from a previous token, so that a Jwt or JwtView
+// reused for another token doesn't keep the claims the new one omits. The
+// strings are cleared rather than replaced to keep their buffers.
+template <typename JwtType>
+void resetClaims(JwtType* jwt) {
+  jwt->payload_str_.clear();
+  jwt->signature_.clear();
+  jwt->alg_.clear();
+  jwt->kid_.clear();
+  jwt->iss_.clear();
+  jwt->audiences_.clear();
+  jwt->sub_.clear();
+  jwt->iat_ = 0;
+  jwt->nbf_ = 0;
+  jwt->exp_ = 0;
+  jwt->jti_.clear();
+}
 
-  StructUtils header_getter(header_pb_);
+// Reads "alg" and "kid" from the header into a Jwt or JwtView. If alg is not
+// empty, it is the only alg accepted.
+template <typename JwtType>
+Status parseHeaderFields(ScannedFields& header_getter, JwtType* jwt,
+                         absl::string_view alg) {
   // Header should contain "alg" and should be a string.
-  if (header_getter.GetString("alg", &alg_) != StructUtils::OK) {
+  if (header_getter.GetString("alg", &jwt->alg_) != StructUtils::OK) {
     return Status::JwtHeaderBadAlg;
   }
 
-  if (!isImplemented(alg_)) {
+  if (!alg.empty()) {
+    // The caller only accepts an implemented alg.
+    if (jwt->alg_ != alg) {
+      return Status::JwksKidAlgMismatch;
+    }
+  } else if (!isImplemented(jwt->alg_)) {
     return Status::JwtHeaderNotImplementedAlg;
   }
 
   // Header may contain "kid", should be a string if exists.
-  if (header_getter.GetString("kid", &kid_) == StructUtils::WRONG_TYPE) {
+  if (header_getter.GetString("kid", &jwt->kid_) == StructUtils::WRONG_TYPE) {
     return Status::JwtHeaderBadKid;
   }
+  return Status::Ok;
+}
 
-  // Parse payload json
-  payload_str_base64url_ = std::string(jwt_split[1]);
-  if (!absl::WebSafeBase64Unescape(payload_str_base64url_, &payload_str_)) {
-    return Status::JwtPayloadParseErrorBadBase64;
-  }
-
-  const auto payload_status = ::google::protobuf::util::JsonStringToMessage(
-      payload_str_, &payload_pb_, options);
-  if (!payload_status.ok()) {
-    return Status::JwtPayloadParseErrorBadJson;
-  }
-
-  StructUtils payload_getter(payload_pb_);
-  if (payload_getter.GetString("iss", &iss_) == StructUtils::WRONG_TYPE) {
+// Reads the registered claims from the payload into a Jwt or JwtView.
+template <typename JwtType>
+Status parsePayloadClaims(ScannedFields& payload_getter, JwtType* jwt) {
+  if (payload_getter.GetString("iss", &jwt->iss_) == StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorIssNotString;
   }
-  if (payload_getter.GetString("sub", &sub_) == StructUtils::WRONG_TYPE) {
+  if (payload_getter.GetString("sub", &jwt->sub_) == StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorSubNotString;
   }
 
-  auto result = payload_getter.GetUInt64("iat", &iat_);
+  auto result = payload_getter.GetUInt64("iat", &jwt->iat_);
   if (result == StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorIatNotInteger;
   } else if (result == StructUtils::NOT_POSITIVE) {
     return Status::JwtPayloadParseErrorIatNotPositive;
   }
 
-  result = payload_getter.GetUInt64("nbf", &nbf_);
+  result = payload_getter.GetUInt64("nbf", &jwt->nbf_);
   if (result == StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorNbfNotInteger;
   } else if (result == StructUtils::NOT_POSITIVE) {
     return Status::JwtPayloadParseErrorNbfNotPositive;
   }
 
-  result = payload_getter.GetUInt64("exp", &exp_);
+  result = payload_getter.GetUInt64("exp", &jwt->exp_);
   if (result == StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorExpNotInteger;
   } else if (result == StructUtils::NOT_POSITIVE) {
     return Status::JwtPayloadParseErrorExpNotPositive;
   }
 
-  if (payload_getter.GetString("jti", &jti_) == StructUtils::WRONG_TYPE) {
+  if (payload_getter.GetString("jti", &jwt->jti_) == StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorJtiNotString;
   }
 
   // "aud" can be either string array or string.
   // GetStringList function will try to read as string, if fails,
   // try to read as string array.
-  if (payload_getter.GetStringList("aud", &audiences_) ==
+  if (payload_getter.GetStringList("aud", &jwt->audiences_) ==
       StructUtils::WRONG_TYPE) {
     return Status::JwtPayloadParseErrorAudNotString;
   }
+  return Status::Ok;
+}
+
+// Decodes a base64url section, timed as a Base64Decode step.
+bool decodeSection(VerifyStats* stats, absl::string_view section,
+                   std::string* out) {
+  StageTimer timer(stats, VerifyStats::Stage::Base64Decode);
+  return base64UrlDecode(section, out);
+}
+
+// Scans a JSON section, timed as a JsonParse step.
+bool scanSection(VerifyStats* stats, absl::string_view json,
+                 ScannedFields* fields) {
+  StageTimer timer(stats, VerifyStats::Stage::JsonParse);
+  return fields->parse(json);
+}
+
+// Parses the header, the payload and the signature of a split jwt into a Jwt
+// or JwtView. Only the claims are kept, the Structs are built on demand. If
+// alg is not empty, it is the only alg accepted.
+template <typename JwtType>
+Status parseSections(const absl::string_view sections[3], JwtType* jwt,
+                     VerifyStats* stats, bool decode_signature = true,
+                     absl::string_view alg = absl::string_view()) {
+  // Parse header json, it is only needed to read "alg" and "kid".
+  std::string header_str;
+  if (!decodeSection(stats, sections[0], &header_str)) {
+    return Status::JwtHeaderParseErrorBadBase64;
+  }
+
+  ScannedFields header_fields({"alg", "kid"});
+  if (!scanSection(stats, header_str, &header_fields)) {
+    return Status::JwtHeaderParseErrorBadJson;
+  }
+
+  Status status = parseHeaderFields(header_fields, jwt, alg);
+  if (status != Status::Ok) {
+    return status;
+  }
+
+  // Parse payload json
+  if (!decodeSection(stats, sections[1], &jwt->payload_str_)) {
+    return Status::JwtPayloadParseErrorBadBase64;
+  }
+
+  ScannedFields payload_fields(
+      {"iss", "sub", "iat", "nbf", "exp", "jti", "aud"});
+  if (!scanSection(stats, jwt->payload_str_, &payload_fields)) {
+    return Status::JwtPayloadParseErrorBadJson;
+  }
+
+  status = parsePayloadClaims(payload_fields, jwt);
+  if (status != Status::Ok) {
+    return status;
+  }
 
   // Set up signature
-  if (!absl::WebSafeBase64Unescape(jwt_split[2], &signature_)) {
+  if (!decode_signature) {
+    return Status::Ok;
+  }
+  if (!decodeSection(stats, sections[2], &jwt->signature_)) {
     // Signature is a bad Base64url input.
     return Status::JwtSignatureParseErrorBadBase64;
   }
   return Status::Ok;
 }
 
-Status Jwt::verifyTimeConstraint(uint64_t now, uint64_t clock_skew) const {
+template <typename JwtType>
+Status verifyTimeConstraintImpl(const JwtType& jwt, uint64_t now,
+                                uint64_t clock_skew) {
   // Check Jwt is active (nbf).
-  if (now + clock_skew < nbf_) {
+  if (now + clock_skew < jwt.nbf_) {
     return Status::JwtNotYetValid;
   }
   // Check JWT has not expired (exp).
-  if (exp_ && now > exp_ + clock_skew) {
+  if (jwt.exp_ && now > jwt.exp_ + clock_skew) {
     return Status::JwtExpired;
   }
   return Status::Ok;
 }
 
+}  // namespace
+
+SharedStruct::SharedStruct(const SharedStruct& other)
+    : pb(std::atomic_load(&other.pb)) {}
+
+SharedStruct& SharedStruct::operator=(const SharedStruct& other) {
+  std::atomic_store(&pb, std::atomic_load(&other.pb));
+  return *this;
+}
+
+Status Jwt::parseFromString(const std::string& jwt) {
+  return parseFromString(jwt, nullptr);
+}
+
+Status Jwt::parseFromString(const std::string& jwt,
+                            ::google::protobuf::Arena* arena) {
+  VerifyStats* stats = verifyStats();
+  resetClaims(this);
+  header_str_base64url_.clear();
+  payload_str_base64url_.clear();
+  signed_data_offset_ = 0;
+  signed_data_len_ = 0;
+  header_pb_.pb.reset();
+  payload_pb_.pb.reset();
+  // jwt must have exactly 2 dots with 3 sections.
+  jwt_ = jwt;
+  arena_ = arena;
+  absl::string_view jwt_split[3];
+  if (!splitJwt(jwt_, jwt_split)) {
+    return reportFailure(stats, Status::JwtBadFormat);
+  }
+
+  absl::string_view signed_data;
+  if (!getSignedData(jwt_split, &signed_data)) {
+    return reportFailure(stats, Status::JwtBadFormat);
+  }
+  signed_data_offset_ = signed_data.data() - jwt_.data();
+  signed_data_len_ = signed_data.size();
+
+  header_str_base64url_ = std::string(jwt_split[0]);
+  payload_str_base64url_ = std::string(jwt_split[1]);
+  return reportFailure(stats, parseSections(jwt_split, this, stats));
+}
+
+const ::google::protobuf::Struct& Jwt::headerPb() const {
+  return getOrParseStruct(header_pb_, arena_, [this]() {
+    std::string header_str;
+    base64UrlDecode(header_str_base64url_, &header_str);
+    return header_str;
+  });
+}
+
+const ::google::protobuf::Struct& Jwt::payloadPb() const {
+  return getOrParseStruct(payload_pb_, arena_,
+                          [this]() { return payload_str_; });
+}
+
+absl::string_view Jwt::signedData() const {
+  return absl::string_view(jwt_).substr(signed_data_offset_, signed_data_len_);
+}
+
+Status Jwt::verifyTimeConstraint(uint64_t now, uint64_t clock_skew) const {
+  return verifyTimeConstraintImpl(*this, now, clock_skew);
+}
+
+Status JwtView::parseFromString(absl::string_view jwt) {
+  arena_ = nullptr;
+  return parse(jwt, /*decode_signature=*/true);
+}
+
+Status JwtView::parseFromString(absl::string_view jwt,
+                                ::google::protobuf::Arena* arena) {
+  arena_ = arena;
+  return parse(jwt, /*decode_signature=*/true);
+}
+
+Status JwtView::parseClaimsFromString(absl::string_view jwt) {
+  arena_ = nullptr;
+  return parse(jwt, /*decode_signature=*/false);
+}
+
+Status JwtView::parseFromStringForAlg(absl::string_view jwt,
+                                      absl::string_view alg) {
+  arena_ = nullptr;
+  return parse(jwt, /*decode_signature=*/true, alg);
+}
+
+Status JwtView::decodeSignature() {
+  VerifyStats* stats = verifyStats();
+  if (!decodeSection(stats, signature_str_base64url_, &signature_)) {
+    // Signature is a bad Base64url input.
+    return reportFailure(stats, Status::JwtSignatureParseErrorBadBase64);
+  }
+  return Status::Ok;
+}
+
+Status JwtView::parse(absl::string_view jwt, bool decode_signature,
+                      absl::string_view alg) {
+  VerifyStats* stats = verifyStats();
+  resetClaims(this);
+  header_str_base64url_ = absl::string_view();
+  payload_str_base64url_ = absl::string_view();
+  signature_str_base64url_ = absl::string_view();
+  signed_data_ = absl::string_view();
+  header_pb_.pb.reset();
+  payload_pb_.pb.reset();
+  // jwt must have exactly 2 dots with 3 sections.
+  jwt_ = jwt;
+  absl::string_view jwt_split[3];
+  if (!splitJwt(jwt, jwt_split)) {
+    return reportFailure(stats, Status::JwtBadFormat);
+  }
+  header_str_base64url_ = jwt_split[0];
+  payload_str_base64url_ = jwt_split[1];
+  signature_str_base64url_ = jwt_split[2];
+
+  if (!getSignedData(jwt_split, &signed_data_)) {
+    return reportFailure(stats, Status::JwtBadFormat);
+  }
+
+  return reportFailure(
+      stats, parseSections(jwt_split, this, stats, decode_signature, alg));
+}
+
+const ::google::protobuf::Struct& JwtView::headerPb() const {
+  return getOrParseStruct(header_pb_, arena_, [this]() {
+    std::string header_str;
+    base64UrlDecode(header_str_base64url_, &header_str);
+    return header_str;
+  });
+}
+
+const ::google::protobuf::Struct& JwtView::payloadPb() const {
+  return getOrParseStruct(payload_pb_, arena_,
+                          [this]() { return payload_str_; });
+}
+
+Status JwtView::verifyTimeConstraint(uint64_t now, uint64_t clock_skew) const {
+  return verifyTimeConstraintImpl(*this, now, clock_skew);
+}
+
 }  // namespace jwt_verify
 }  // namespace google
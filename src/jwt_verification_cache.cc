@@ -0,0 +1,221 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/jwt_verification_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "absl/hash/hash.h"
+#include "jwt_verify_lib/verify.h"
+#include "jwt_verify_lib/verify_stats.h"
+
+namespace google {
+namespace jwt_verify {
+
+namespace {
+
+// The time after which an entry of jwt is expired, see Entry::expires_at.
+uint64_t expiresAt(const Jwt& jwt, uint64_t clock_skew) {
+  return jwt.exp_ ? jwt.exp_ + clock_skew : 0;
+}
+
+// Tells whether an Entry or a Rejection is expired at now, the same as
+// Jwt::verifyTimeConstraint returning JwtExpired.
+struct ExpiredAt {
+  template <typename T>
+  bool operator()(const T& entry) const {
+    return entry.expires_at != 0 && now > entry.expires_at;
+  }
+
+  uint64_t now;
+};
+
+}  // namespace
+
+constexpr double JwtVerificationCache::kDefaultMaxIdleSeconds;
+
+JwtVerificationCache::JwtVerificationCache(size_t max_entries,
+                                           size_t num_shards)
+    // Each shard holds at least one token.
+    : cache_(std::min(num_shards, std::max<size_t>(max_entries, 1)),
+             max_entries),
+      rejected_(std::min(num_shards, std::max<size_t>(max_entries, 1)),
+                max_entries) {
+  setMaxIdleSeconds(kDefaultMaxIdleSeconds);
+}
+
+void JwtVerificationCache::removeExpiredEntries(uint64_t now) {
+  cache_.removeIf(ExpiredAt{now});
+  rejected_.removeIf(ExpiredAt{now});
+  cache_.removeExpiredEntries();
+  rejected_.removeExpiredEntries();
+}
+
+void JwtVerificationCache::setMaxIdleSeconds(double seconds) {
+  cache_.setMaxIdleSeconds(seconds);
+  rejected_.setMaxIdleSeconds(seconds);
+}
+
+SharedJwt JwtVerificationCache::lookup(const Key& key, absl::string_view token,
+                                       uint64_t now, uint64_t clock_skew) {
+  SharedJwt jwt;
+  {
+    decltype(cache_)::ScopedLookup lookup(&cache_, key);
+    if (!lookup.found()) {
+      return nullptr;
+    }
+    jwt = lookup.value()->jwt;
+  }
+
+  if (jwt->jwt_ != token) {
+    // A hash collision.
+    return nullptr;
+  }
+  if (jwt->verifyTimeConstraint(now, clock_skew) == Status::JwtExpired) {
+    cache_.remove(key);
+    return nullptr;
+  }
+  return jwt;
+}
+
+SharedJwt JwtVerificationCache::lookupRejected(
+    const Key& key, absl::string_view token, Status* status) {
+  decltype(rejected_)::ScopedLookup lookup(&rejected_, key);
+  if (!lookup.found() || lookup.value()->jwt == nullptr ||
+      lookup.value()->jwt->jwt_ != token) {
+    return nullptr;
+  }
+  *status = lookup.value()->status;
+  return lookup.value()->jwt;
+}
+
+bool JwtVerificationCache::isKidAlgRejected(const Key& key,
+                                            absl::string_view kid,
+                                            absl::string_view alg) {
+  decltype(rejected_)::ScopedLookup lookup(&rejected_, key);
+  return lookup.found() && lookup.value()->jwt == nullptr &&
+         lookup.value()->kid == kid && lookup.value()->alg == alg;
+}
+
+Status JwtVerificationCache::verify(absl::string_view token, const Jwks& jwks,
+                                    const std::vector<std::string>& audiences,
+                                    uint64_t now, uint64_t clock_skew,
+                                    SharedJwt* jwt) {
+  return verify(token, jwks, CheckAudience(audiences), now, clock_skew, jwt);
+}
+
+Status JwtVerificationCache::verify(absl::string_view token, const Jwks& jwks,
+                                    const CheckAudience& audiences,
+                                    uint64_t now, uint64_t clock_skew,
+                                    SharedJwt* jwt) {
+  const Key key{absl::Hash<absl::string_view>()(token), jwks.generation()};
+  SharedJwt cached = lookup(key, token, now, clock_skew);
+  VerifyStats* stats = verifyStats();
+
+  if (cached == nullptr) {
+    // The status of the signature if the token was already rejected.
+    Status signature_status = Status::Ok;
+    SharedJwt parsed = lookupRejected(key, token, &signature_status);
+    if (stats != nullptr) {
+      stats->onCacheLookup(parsed != nullptr);
+    }
+    if (parsed == nullptr) {
+      auto new_jwt = std::make_shared<Jwt>();
+      Status status = new_jwt->parseFromString(std::string(token));
+      if (status != Status::Ok) {
+        return status;
+      }
+      parsed = std::move(new_jwt);
+    }
+
+    // The checks are done in the same order as verifyJwt(). The failures
+    // found here are reported too, so that the replayed rejections are
+    // counted.
+    if (!audiences.areAudiencesAllowed(parsed->audiences_)) {
+      return reportFailure(stats, Status::JwtAudienceNotAllowed);
+    }
+    Status status = parsed->verifyTimeConstraint(now, clock_skew);
+    if (status != Status::Ok) {
+      if (status == Status::JwtExpired && signature_status != Status::Ok) {
+        rejected_.remove(key);
+      }
+      return reportFailure(stats, status);
+    }
+    if (signature_status != Status::Ok) {
+      return reportFailure(stats, signature_status);
+    }
+
+    const Key kid_alg_key{
+        absl::Hash<std::pair<absl::string_view, absl::string_view>>()(
+            std::make_pair(absl::string_view(parsed->kid_),
+                           absl::string_view(parsed->alg_))),
+        jwks.generation()};
+    if (isKidAlgRejected(kid_alg_key, parsed->kid_, parsed->alg_)) {
+      return reportFailure(stats, Status::JwksKidAlgMismatch);
+    }
+
+    status = verifyJwtWithoutTimeChecking(*parsed, jwks);
+    if (status == Status::JwksKidAlgMismatch) {
+      // Any token with this kid and alg gets the same status.
+      rejected_.insertAndSweep(
+          kid_alg_key,
+          new Rejection{nullptr, parsed->kid_, parsed->alg_, status, 0}, 1,
+          now, ExpiredAt{now});
+      return status;
+    }
+    if (status != Status::Ok) {
+      rejected_.insertAndSweep(
+          key,
+          new Rejection{parsed, "", "", status,
+                        expiresAt(*parsed, clock_skew)},
+          1, now, ExpiredAt{now});
+      return status;
+    }
+
+    cache_.insertAndSweep(key,
+                          new Entry{parsed, expiresAt(*parsed, clock_skew)}, 1,
+                          now, ExpiredAt{now});
+    if (jwt != nullptr) {
+      *jwt = std::move(parsed);
+    }
+    return Status::Ok;
+  }
+
+  // The signature was verified, only the checks depending on the caller and
+  // on the time are left.
+  if (stats != nullptr) {
+    stats->onCacheLookup(true);
+  }
+  if (!audiences.areAudiencesAllowed(cached->audiences_)) {
+    return reportFailure(stats, Status::JwtAudienceNotAllowed);
+  }
+  Status status = cached->verifyTimeConstraint(now, clock_skew);
+  if (status != Status::Ok) {
+    return reportFailure(stats, status);
+  }
+  if (jwt != nullptr) {
+    *jwt = std::move(cached);
+  }
+  return Status::Ok;
+}
+
+size_t JwtVerificationCache::entries() const { return cache_.entries(); }
+
+size_t JwtVerificationCache::rejectedEntries() const {
+  return rejected_.entries();
+}
+
+}  // namespace jwt_verify
+}  // namespace google
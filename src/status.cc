@@ -178,6 +178,16 @@ std::string getStatusString(Status status) {
 
     case Status::JwksBioAllocError:
       return "Failed to create BIO due to memory allocation failure";
+
+    case Status::JwksBinaryParseError:
+      return "Binary Jwks is truncated or malformed";
+    case Status::JwksBinaryBadVersion:
+      return "Binary Jwks has an unsupported format version";
+    case Status::JwksStoreOpenError:
+      return "Jwks store file can't be opened or mapped";
+
+    case Status::JwksFetchError:
+      return "Jwks can't be fetched";
   };
 }
 
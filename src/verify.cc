@@ -14,9 +14,21 @@
 
 #include "jwt_verify_lib/verify.h"
 
+#include <assert.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
 #include "absl/time/clock.h"
 #include "jwt_verify_lib/check_audience.h"
+#include "jwt_verify_lib/verify_stats.h"
 #include "openssl/bn.h"
 #include "openssl/curve25519.h"
 #include "openssl/ecdsa.h"
@@ -36,24 +48,22 @@ inline const uint8_t* castToUChar(const absl::string_view& str) {
   return reinterpret_cast<const uint8_t*>(str.data());
 }
 
-bool verifySignatureRSA(RSA* key, const EVP_MD* md, const uint8_t* signature,
+bool verifySignatureRSA(VerifyContext& context, EVP_PKEY* key,
+                        const EVP_MD* md, const uint8_t* signature,
                         size_t signature_len, const uint8_t* signed_data,
                         size_t signed_data_len) {
   if (key == nullptr || md == nullptr || signature == nullptr ||
       signed_data == nullptr) {
     return false;
   }
-  bssl::UniquePtr<EVP_PKEY> evp_pkey(EVP_PKEY_new());
-  if (EVP_PKEY_set1_RSA(evp_pkey.get(), key) != 1) {
+
+  EVP_MD_CTX* md_ctx = context.mdCtx();
+  if (md_ctx == nullptr) {
     return false;
   }
-
-  bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_create());
-  if (EVP_DigestVerifyInit(md_ctx.get(), nullptr, md, nullptr,
-                           evp_pkey.get()) == 1) {
-    if (EVP_DigestVerifyUpdate(md_ctx.get(), signed_data, signed_data_len) ==
-        1) {
-      if (EVP_DigestVerifyFinal(md_ctx.get(), signature, signature_len) == 1) {
+  if (EVP_DigestVerifyInit(md_ctx, nullptr, md, nullptr, key) == 1) {
+    if (EVP_DigestVerifyUpdate(md_ctx, signed_data, signed_data_len) == 1) {
+      if (EVP_DigestVerifyFinal(md_ctx, signature, signature_len) == 1) {
         return true;
       }
     }
@@ -62,32 +72,33 @@ bool verifySignatureRSA(RSA* key, const EVP_MD* md, const uint8_t* signature,
   return false;
 }
 
-bool verifySignatureRSA(RSA* key, const EVP_MD* md, absl::string_view signature,
+bool verifySignatureRSA(VerifyContext& context, EVP_PKEY* key,
+                        const EVP_MD* md, absl::string_view signature,
                         absl::string_view signed_data) {
-  return verifySignatureRSA(key, md, castToUChar(signature), signature.length(),
-                            castToUChar(signed_data), signed_data.length());
+  return verifySignatureRSA(context, key, md, castToUChar(signature),
+                            signature.length(), castToUChar(signed_data),
+                            signed_data.length());
 }
 
-bool verifySignatureRSAPSS(RSA* key, const EVP_MD* md, const uint8_t* signature,
+bool verifySignatureRSAPSS(VerifyContext& context, EVP_PKEY* key,
+                           const EVP_MD* md, const uint8_t* signature,
                            size_t signature_len, const uint8_t* signed_data,
                            size_t signed_data_len) {
   if (key == nullptr || md == nullptr || signature == nullptr ||
       signed_data == nullptr) {
     return false;
   }
-  bssl::UniquePtr<EVP_PKEY> evp_pkey(EVP_PKEY_new());
-  if (EVP_PKEY_set1_RSA(evp_pkey.get(), key) != 1) {
+
+  EVP_MD_CTX* md_ctx = context.mdCtx();
+  if (md_ctx == nullptr) {
     return false;
   }
-
-  bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_create());
   // pctx is owned by md_ctx, no need to free it separately.
   EVP_PKEY_CTX* pctx;
-  if (EVP_DigestVerifyInit(md_ctx.get(), &pctx, md, nullptr, evp_pkey.get()) ==
-          1 &&
+  if (EVP_DigestVerifyInit(md_ctx, &pctx, md, nullptr, key) == 1 &&
       EVP_PKEY_CTX_set_rsa_padding(pctx, RSA_PKCS1_PSS_PADDING) == 1 &&
       EVP_PKEY_CTX_set_rsa_mgf1_md(pctx, md) == 1 &&
-      EVP_DigestVerify(md_ctx.get(), signature, signature_len, signed_data,
+      EVP_DigestVerify(md_ctx, signature, signature_len, signed_data,
                        signed_data_len) == 1) {
     return true;
   }
@@ -96,38 +107,37 @@ bool verifySignatureRSAPSS(RSA* key, const EVP_MD* md, const uint8_t* signature,
   return false;
 }
 
-bool verifySignatureRSAPSS(RSA* key, const EVP_MD* md,
-                           absl::string_view signature,
+bool verifySignatureRSAPSS(VerifyContext& context, EVP_PKEY* key,
+                           const EVP_MD* md, absl::string_view signature,
                            absl::string_view signed_data) {
-  return verifySignatureRSAPSS(key, md, castToUChar(signature),
+  return verifySignatureRSAPSS(context, key, md, castToUChar(signature),
                                signature.length(), castToUChar(signed_data),
                                signed_data.length());
 }
 
-bool verifySignatureEC(EC_KEY* key, const EVP_MD* md, const uint8_t* signature,
-                       size_t signature_len, const uint8_t* signed_data,
-                       size_t signed_data_len) {
-  if (key == nullptr || md == nullptr || signature == nullptr ||
-      signed_data == nullptr) {
-    return false;
-  }
-  bssl::UniquePtr<EVP_MD_CTX> md_ctx(EVP_MD_CTX_create());
-  std::vector<uint8_t> digest(EVP_MAX_MD_SIZE);
-  unsigned int digest_len = 0;
+// A one-shot hash function, such as SHA256(), working on the stack.
+struct EcDigest {
+  uint8_t* (*hash)(const uint8_t* data, size_t len, uint8_t* out);
+  size_t length;
+};
 
-  if (EVP_DigestInit(md_ctx.get(), md) == 0) {
+bool verifySignatureEC(VerifyContext& context, EC_KEY* key,
+                       size_t key_signature_len, const EcDigest& digest,
+                       const uint8_t* signature, size_t signature_len,
+                       const uint8_t* signed_data, size_t signed_data_len) {
+  if (key == nullptr || signature == nullptr || signed_data == nullptr) {
     return false;
   }
-
-  if (EVP_DigestUpdate(md_ctx.get(), signed_data, signed_data_len) == 0) {
+  // r and s are each as long as the field elements of the curve, a
+  // signature of another length is rejected without any bignum work.
+  if (signature_len != key_signature_len) {
     return false;
   }
 
-  if (EVP_DigestFinal(md_ctx.get(), digest.data(), &digest_len) == 0) {
-    return false;
-  }
+  uint8_t hash[EVP_MAX_MD_SIZE];
+  digest.hash(signed_data, signed_data_len, hash);
 
-  bssl::UniquePtr<ECDSA_SIG> ecdsa_sig(ECDSA_SIG_new());
+  ECDSA_SIG* ecdsa_sig = context.ecdsaSig();
   if (!ecdsa_sig) {
     return false;
   }
@@ -138,7 +148,7 @@ bool verifySignatureEC(EC_KEY* key, const EVP_MD* md, const uint8_t* signature,
     return false;
   }
 
-  if (ECDSA_do_verify(digest.data(), digest_len, ecdsa_sig.get(), key) == 1) {
+  if (ECDSA_do_verify(hash, digest.length, ecdsa_sig, key) == 1) {
     return true;
   }
 
@@ -146,10 +156,12 @@ bool verifySignatureEC(EC_KEY* key, const EVP_MD* md, const uint8_t* signature,
   return false;
 }
 
-bool verifySignatureEC(EC_KEY* key, const EVP_MD* md,
+bool verifySignatureEC(VerifyContext& context, EC_KEY* key,
+                       size_t key_signature_len, const EcDigest& digest,
                        absl::string_view signature,
                        absl::string_view signed_data) {
-  return verifySignatureEC(key, md, castToUChar(signature), signature.length(),
+  return verifySignatureEC(context, key, key_signature_len, digest,
+                           castToUChar(signature), signature.length(),
                            castToUChar(signed_data), signed_data.length());
 }
 
@@ -161,10 +173,10 @@ bool verifySignatureOct(const uint8_t* key, size_t key_len, const EVP_MD* md,
     return false;
   }
 
-  std::vector<uint8_t> out(EVP_MAX_MD_SIZE);
+  uint8_t out[EVP_MAX_MD_SIZE];
   unsigned int out_len = 0;
-  if (HMAC(md, key, key_len, signed_data, signed_data_len, out.data(),
-           &out_len) == nullptr) {
+  if (HMAC(md, key, key_len, signed_data, signed_data_len, out, &out_len) ==
+      nullptr) {
     ERR_clear_error();
     return false;
   }
@@ -173,7 +185,7 @@ bool verifySignatureOct(const uint8_t* key, size_t key_len, const EVP_MD* md,
     return false;
   }
 
-  if (CRYPTO_memcmp(out.data(), signature, signature_len) == 0) {
+  if (CRYPTO_memcmp(out, signature, signature_len) == 0) {
     return true;
   }
 
@@ -189,6 +201,25 @@ bool verifySignatureOct(absl::string_view key, const EVP_MD* md,
                             castToUChar(signed_data), signed_data.length());
 }
 
+// Verifies an HMAC with a context already keyed by HMAC_Init_ex.
+bool verifySignatureOct(HMAC_CTX* ctx, absl::string_view signature,
+                        absl::string_view signed_data) {
+  if (ctx == nullptr) {
+    return false;
+  }
+
+  uint8_t out[EVP_MAX_MD_SIZE];
+  unsigned int out_len = 0;
+  if (HMAC_Update(ctx, castToUChar(signed_data), signed_data.length()) != 1 ||
+      HMAC_Final(ctx, out, &out_len) != 1) {
+    ERR_clear_error();
+    return false;
+  }
+
+  return out_len == signature.length() &&
+         CRYPTO_memcmp(out, signature.data(), out_len) == 0;
+}
+
 Status verifySignatureEd25519(absl::string_view key,
                               absl::string_view signature,
                               absl::string_view signed_data) {
@@ -205,92 +236,386 @@ Status verifySignatureEd25519(absl::string_view key,
   return Status::JwtVerificationFail;
 }
 
-}  // namespace
-
-Status verifyJwtWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks) {
-  // Verify signature
-  std::string signed_data =
-      jwt.header_str_base64url_ + '.' + jwt.payload_str_base64url_;
-  bool kid_alg_matched = false;
-  for (const auto& jwk : jwks.keys()) {
-    // If kid is specified in JWT, JWK with the same kid is used for
-    // verification.
-    // If kid is not specified in JWT, try all JWK.
-    if (!jwt.kid_.empty() && !jwk->kid_.empty() && jwk->kid_ != jwt.kid_) {
-      continue;
+// HMAC contexts of the keys used by a batch task. A key's context is copied
+// from its template for the first token of the task; for the next tokens it
+// restarts from the keyed state it already holds, which copies one digest
+// state instead of the three of HMAC_CTX_copy_ex.
+class BatchHmacContexts {
+ public:
+  /**
+   * Gets the context of a key, ready to hash a message.
+   * @param jwk the key, the same digest is used for all its calls.
+   * @param key_template the keyed HMAC of jwk.
+   * @return the context, or nullptr on failure.
+   */
+  HMAC_CTX* get(const Jwks::Pubkey& jwk, const HMAC_CTX* key_template) {
+    for (auto& entry : ctxs_) {
+      if (entry.first == &jwk) {
+        // A null key restarts from the keyed state of the context.
+        if (HMAC_Init_ex(entry.second.get(), nullptr, 0, nullptr, nullptr) !=
+            1) {
+          ERR_clear_error();
+          return nullptr;
+        }
+        return entry.second.get();
+      }
     }
-
-    // The same alg must be used.
-    if (!jwk->alg_.empty() && jwk->alg_ != jwt.alg_) {
-      continue;
+    bssl::UniquePtr<HMAC_CTX> ctx(HMAC_CTX_new());
+    if (ctx == nullptr || HMAC_CTX_copy_ex(ctx.get(), key_template) != 1) {
+      ERR_clear_error();
+      return nullptr;
     }
-    kid_alg_matched = true;
+    ctxs_.emplace_back(&jwk, std::move(ctx));
+    return ctxs_.back().second.get();
+  }
 
-    if (jwk->kty_ == "EC") {
-      const EVP_MD* md;
-      if (jwt.alg_ == "ES384") {
-        md = EVP_sha384();
-      } else if (jwt.alg_ == "ES512") {
-        md = EVP_sha512();
-      } else {
-        // default to SHA256
-        md = EVP_sha256();
-      }
+ private:
+  // A task has few candidate keys, a vector is faster than a map.
+  std::vector<std::pair<const Jwks::Pubkey*, bssl::UniquePtr<HMAC_CTX>>>
+      ctxs_;
+};
+
+// The keys and digests to verify the tokens with a given kid and alg.
+struct KeyCandidates {
+  // The alg of the tokens.
+  absl::string_view alg;
+  // Keys with a matching kid, in keyset order.
+  const std::vector<const Jwks::Pubkey*>* keys;
+  // The digests per key type.
+  EcDigest ec_digest;
+  const EVP_MD* rsa_md;
+  const EVP_MD* oct_md;
+  // The keyed HMAC of oct_md.
+  bssl::UniquePtr<HMAC_CTX> Jwks::Pubkey::*oct_template;
+  // Whether RSA keys are used with PKCS #1 v1.5 or PSS padding.
+  bool rsa_pkcs1;
+  bool rsa_pss;
+  // The HMAC contexts of a batch task, or nullptr to use VerifyContext.
+  BatchHmacContexts* batch_hmac = nullptr;
+};
+
+KeyCandidates resolveKeys(const Jwks& jwks, absl::string_view kid,
+                          absl::string_view alg_str) {
+  using Algorithm = Jwks::Algorithm;
+  StageTimer timer(verifyStats(), VerifyStats::Stage::KeyLookup);
+  const Algorithm alg = Jwks::algorithmFromString(alg_str);
+
+  KeyCandidates candidates;
+  candidates.alg = alg_str;
+  // If kid is specified in JWT, JWK with the same kid or without kid is used
+  // for verification.
+  // If kid is not specified in JWT, try all JWK.
+  candidates.keys = &jwks.keysForKid(kid);
+
+  if (alg == Algorithm::ES384) {
+    candidates.ec_digest = {SHA384, SHA384_DIGEST_LENGTH};
+  } else if (alg == Algorithm::ES512) {
+    candidates.ec_digest = {SHA512, SHA512_DIGEST_LENGTH};
+  } else {
+    // default to SHA256
+    candidates.ec_digest = {SHA256, SHA256_DIGEST_LENGTH};
+  }
+
+  if (alg == Algorithm::RS384 || alg == Algorithm::PS384) {
+    candidates.rsa_md = EVP_sha384();
+  } else if (alg == Algorithm::RS512 || alg == Algorithm::PS512) {
+    candidates.rsa_md = EVP_sha512();
+  } else {
+    // default to SHA256
+    candidates.rsa_md = EVP_sha256();
+  }
+  candidates.rsa_pkcs1 = alg == Algorithm::RS256 ||
+                         alg == Algorithm::RS384 || alg == Algorithm::RS512;
+  candidates.rsa_pss = alg == Algorithm::PS256 || alg == Algorithm::PS384 ||
+                       alg == Algorithm::PS512;
 
-      if (verifySignatureEC(jwk->ec_key_.get(), md, jwt.signature_,
-                            signed_data)) {
+  if (alg == Algorithm::HS384) {
+    candidates.oct_md = EVP_sha384();
+    candidates.oct_template = &Jwks::Pubkey::hmac_sha384_;
+  } else if (alg == Algorithm::HS512) {
+    candidates.oct_md = EVP_sha512();
+    candidates.oct_template = &Jwks::Pubkey::hmac_sha512_;
+  } else {
+    // default to SHA256
+    candidates.oct_md = EVP_sha256();
+    candidates.oct_template = &Jwks::Pubkey::hmac_sha256_;
+  }
+  return candidates;
+}
+
+// Returns true if the key may verify tokens of the candidates alg.
+bool isKeyAlgMatching(const KeyCandidates& candidates,
+                      const Jwks::Pubkey& jwk) {
+  // The same alg must be used. alg_ is compared rather than algorithm_ as
+  // callers may still adjust alg_ after the keys are loaded.
+  return jwk.alg_.empty() || jwk.alg_ == candidates.alg;
+}
+
+// Verifies signature over signed_data with a key of the candidates. Returns
+// Ok, JwtVerificationFail, or an error with the JWT making the other keys
+// fail too.
+Status verifySignatureWithKey(const KeyCandidates& candidates,
+                              const Jwks::Pubkey& jwk,
+                              absl::string_view signature,
+                              absl::string_view signed_data,
+                              VerifyContext& context) {
+  StageTimer timer(verifyStats(), VerifyStats::Stage::Signature);
+  switch (jwk.key_type_) {
+    case Jwks::KeyType::EC:
+      if (verifySignatureEC(context, jwk.ec_key_.get(), jwk.ec_signature_len_,
+                            candidates.ec_digest, signature, signed_data)) {
         // Verification succeeded.
         return Status::Ok;
       }
-    } else if (jwk->kty_ == "RSA") {
-      const EVP_MD* md;
-      if (jwt.alg_ == "RS384" || jwt.alg_ == "PS384") {
-        md = EVP_sha384();
-      } else if (jwt.alg_ == "RS512" || jwt.alg_ == "PS512") {
-        md = EVP_sha512();
-      } else {
-        // default to SHA256
-        md = EVP_sha256();
-      }
-
-      if (jwt.alg_.compare(0, 2, "RS") == 0) {
-        if (verifySignatureRSA(jwk->rsa_.get(), md, jwt.signature_,
-                               signed_data)) {
+      break;
+    case Jwks::KeyType::RSA:
+      if (candidates.rsa_pkcs1) {
+        if (verifySignatureRSA(context, jwk.evp_pkey_.get(), candidates.rsa_md,
+                               signature, signed_data)) {
           // Verification succeeded.
           return Status::Ok;
         }
-      } else if (jwt.alg_.compare(0, 2, "PS") == 0) {
-        if (verifySignatureRSAPSS(jwk->rsa_.get(), md, jwt.signature_,
-                                  signed_data)) {
+      } else if (candidates.rsa_pss) {
+        if (verifySignatureRSAPSS(context, jwk.evp_pkey_.get(),
+                                  candidates.rsa_md, signature, signed_data)) {
           // Verification succeeded.
           return Status::Ok;
         }
       }
-    } else if (jwk->kty_ == "oct") {
-      const EVP_MD* md;
-      if (jwt.alg_ == "HS384") {
-        md = EVP_sha384();
-      } else if (jwt.alg_ == "HS512") {
-        md = EVP_sha512();
-      } else {
-        // default to SHA256
-        md = EVP_sha256();
-      }
-
-      if (verifySignatureOct(jwk->hmac_key_, md, jwt.signature_, signed_data)) {
+      break;
+    case Jwks::KeyType::Oct: {
+      // Copying the keyed HMAC saves hashing the padded key again.
+      const HMAC_CTX* key_template = (jwk.*candidates.oct_template).get();
+      if (key_template == nullptr
+              ? verifySignatureOct(jwk.hmac_key_, candidates.oct_md, signature,
+                                   signed_data)
+              : verifySignatureOct(
+                    candidates.batch_hmac != nullptr
+                        ? candidates.batch_hmac->get(jwk, key_template)
+                        : context.hmacCtx(key_template),
+                    signature, signed_data)) {
         // Verification succeeded.
         return Status::Ok;
       }
-    } else if (jwk->kty_ == "OKP" && jwk->crv_ == "Ed25519") {
-      Status status = verifySignatureEd25519(jwk->okp_key_raw_, jwt.signature_,
-                                             signed_data);
-      // For verification failures keep going and try the rest of the keys in
-      // the JWKS. Otherwise status is either OK or an error with the JWT and we
-      // can return immediately.
+      break;
+    }
+    case Jwks::KeyType::OKP: {
+      Status status =
+          verifySignatureEd25519(jwk.okp_key_raw_, signature, signed_data);
+      // For verification failures keep going and try the rest of the keys
+      // in the JWKS. Otherwise status is either OK or an error with the JWT
+      // and we can return immediately.
+      if (status == Status::Ok ||
+          status == Status::JwtEd25519SignatureWrongLength) {
+        return status;
+      }
+      break;
+    }
+    case Jwks::KeyType::Unknown:
+      break;
+  }
+  return Status::JwtVerificationFail;
+}
+
+// The candidate keys of a Verifier, everything depending on the alg is known
+// at compile time.
+template <Jwks::Algorithm Alg>
+struct FixedAlgCandidates {
+  // Keys with a matching kid, in keyset order.
+  const std::vector<const Jwks::Pubkey*>* keys;
+};
+
+// The name of an implemented alg.
+constexpr const char* algName(Jwks::Algorithm alg) {
+  using Algorithm = Jwks::Algorithm;
+  switch (alg) {
+    case Algorithm::RS256:
+      return "RS256";
+    case Algorithm::RS384:
+      return "RS384";
+    case Algorithm::RS512:
+      return "RS512";
+    case Algorithm::PS256:
+      return "PS256";
+    case Algorithm::PS384:
+      return "PS384";
+    case Algorithm::PS512:
+      return "PS512";
+    case Algorithm::ES256:
+      return "ES256";
+    case Algorithm::ES384:
+      return "ES384";
+    case Algorithm::ES512:
+      return "ES512";
+    case Algorithm::HS256:
+      return "HS256";
+    case Algorithm::HS384:
+      return "HS384";
+    case Algorithm::HS512:
+      return "HS512";
+    case Algorithm::EdDSA:
+      return "EdDSA";
+    default:
+      return "";
+  }
+}
+
+// The type of the keys verifying an alg.
+constexpr Jwks::KeyType algKeyType(Jwks::Algorithm alg) {
+  using Algorithm = Jwks::Algorithm;
+  switch (alg) {
+    case Algorithm::RS256:
+    case Algorithm::RS384:
+    case Algorithm::RS512:
+    case Algorithm::PS256:
+    case Algorithm::PS384:
+    case Algorithm::PS512:
+      return Jwks::KeyType::RSA;
+    case Algorithm::ES256:
+    case Algorithm::ES384:
+    case Algorithm::ES512:
+      return Jwks::KeyType::EC;
+    case Algorithm::HS256:
+    case Algorithm::HS384:
+    case Algorithm::HS512:
+      return Jwks::KeyType::Oct;
+    case Algorithm::EdDSA:
+      return Jwks::KeyType::OKP;
+    default:
+      return Jwks::KeyType::Unknown;
+  }
+}
+
+// The SHA-2 digest size of an alg in bits, 256 if it doesn't use one.
+constexpr int algHashBits(Jwks::Algorithm alg) {
+  using Algorithm = Jwks::Algorithm;
+  return alg == Algorithm::RS384 || alg == Algorithm::PS384 ||
+                 alg == Algorithm::ES384 || alg == Algorithm::HS384
+             ? 384
+             : alg == Algorithm::RS512 || alg == Algorithm::PS512 ||
+                       alg == Algorithm::ES512 || alg == Algorithm::HS512
+                   ? 512
+                   : 256;
+}
+
+constexpr bool algIsPss(Jwks::Algorithm alg) {
+  return alg == Jwks::Algorithm::PS256 || alg == Jwks::Algorithm::PS384 ||
+         alg == Jwks::Algorithm::PS512;
+}
+
+inline const EVP_MD* hashMd(int bits) {
+  return bits == 384 ? EVP_sha384() : bits == 512 ? EVP_sha512() : EVP_sha256();
+}
+
+inline EcDigest ecDigest(int bits) {
+  return bits == 384   ? EcDigest{SHA384, SHA384_DIGEST_LENGTH}
+         : bits == 512 ? EcDigest{SHA512, SHA512_DIGEST_LENGTH}
+                       : EcDigest{SHA256, SHA256_DIGEST_LENGTH};
+}
+
+template <Jwks::Algorithm Alg>
+FixedAlgCandidates<Alg> resolveKeys(const Jwks& jwks, absl::string_view kid) {
+  StageTimer timer(verifyStats(), VerifyStats::Stage::KeyLookup);
+  return {&jwks.keysForKid(kid)};
+}
+
+template <Jwks::Algorithm Alg>
+bool isKeyAlgMatching(const FixedAlgCandidates<Alg>& candidates,
+                      const Jwks::Pubkey& jwk) {
+  return jwk.alg_.empty() || jwk.alg_ == algName(Alg);
+}
+
+// The same as verifySignatureWithKey for KeyCandidates, with the checks of
+// the alg resolved by the compiler. A key of another type can't verify the
+// signature.
+template <Jwks::Algorithm Alg>
+Status verifySignatureWithKey(const FixedAlgCandidates<Alg>& candidates,
+                              const Jwks::Pubkey& jwk,
+                              absl::string_view signature,
+                              absl::string_view signed_data,
+                              VerifyContext& context) {
+  StageTimer timer(verifyStats(), VerifyStats::Stage::Signature);
+  constexpr Jwks::KeyType key_type = algKeyType(Alg);
+  constexpr int bits = algHashBits(Alg);
+  if (jwk.key_type_ != key_type) {
+    return Status::JwtVerificationFail;
+  }
+
+  bool verified = false;
+  switch (key_type) {
+    case Jwks::KeyType::EC:
+      verified = verifySignatureEC(context, jwk.ec_key_.get(),
+                                   jwk.ec_signature_len_, ecDigest(bits),
+                                   signature, signed_data);
+      break;
+    case Jwks::KeyType::RSA:
+      verified = algIsPss(Alg)
+                     ? verifySignatureRSAPSS(context, jwk.evp_pkey_.get(),
+                                             hashMd(bits), signature,
+                                             signed_data)
+                     : verifySignatureRSA(context, jwk.evp_pkey_.get(),
+                                          hashMd(bits), signature,
+                                          signed_data);
+      break;
+    case Jwks::KeyType::Oct: {
+      const bssl::UniquePtr<HMAC_CTX>& key_template =
+          bits == 384   ? jwk.hmac_sha384_
+          : bits == 512 ? jwk.hmac_sha512_
+                        : jwk.hmac_sha256_;
+      verified = key_template != nullptr
+                     ? verifySignatureOct(context.hmacCtx(key_template.get()),
+                                          signature, signed_data)
+                     : verifySignatureOct(jwk.hmac_key_, hashMd(bits),
+                                          signature, signed_data);
+      break;
+    }
+    case Jwks::KeyType::OKP: {
+      Status status =
+          verifySignatureEd25519(jwk.okp_key_raw_, signature, signed_data);
       if (status == Status::Ok ||
           status == Status::JwtEd25519SignatureWrongLength) {
         return status;
       }
+      break;
+    }
+    case Jwks::KeyType::Unknown:
+      break;
+  }
+  return verified ? Status::Ok : Status::JwtVerificationFail;
+}
+
+// Verifies signature over signed_data with the candidate keys, but the key
+// at index skip_key, already tried by the caller. If verified_key is not
+// null, it is set to the index of the key verifying the signature. If
+// keys_tried is not null, it is incremented for each key tried.
+template <typename Candidates>
+Status verifySignature(const Candidates& candidates,
+                       absl::string_view signature,
+                       absl::string_view signed_data, VerifyContext& context,
+                       size_t skip_key = Jwks::kNoKeyHint,
+                       size_t* verified_key = nullptr,
+                       size_t* keys_tried = nullptr) {
+  bool kid_alg_matched = false;
+  const std::vector<const Jwks::Pubkey*>& keys = *candidates.keys;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!isKeyAlgMatching(candidates, *keys[i])) {
+      continue;
+    }
+    kid_alg_matched = true;
+    if (i == skip_key) {
+      continue;
+    }
+
+    if (keys_tried != nullptr) {
+      ++*keys_tried;
+    }
+    Status status = verifySignatureWithKey(candidates, *keys[i], signature,
+                                           signed_data, context);
+    if (status == Status::Ok && verified_key != nullptr) {
+      *verified_key = i;
+    }
+    if (status != Status::JwtVerificationFail) {
+      return status;
     }
   }
 
@@ -299,18 +624,300 @@ Status verifyJwtWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks) {
                          : Status::JwksKidAlgMismatch;
 }
 
+// Returns true if a candidate key may verify the tokens, checked the same way
+// as in verifySignature.
+bool hasMatchingKey(const KeyCandidates& candidates) {
+  for (const Jwks::Pubkey* jwk : *candidates.keys) {
+    if (isKeyAlgMatching(candidates, *jwk)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Verifies the signature of a Jwt or JwtView over signed_data. The key which
+// verified the last token of the same issuer, kid and alg is tried first.
+// keys_tried is incremented for each key tried.
+template <typename Candidates, typename JwtType>
+Status verifyJwtSignature(const Candidates& candidates, const JwtType& jwt,
+                          absl::string_view signed_data, const Jwks& jwks,
+                          VerifyContext& context, size_t* keys_tried) {
+  const std::vector<const Jwks::Pubkey*>& keys = *candidates.keys;
+
+  size_t hint = keys.size() > 1 ? jwks.keyHint(jwt.iss_, jwt.kid_, jwt.alg_)
+                                : Jwks::kNoKeyHint;
+  if (hint < keys.size() && isKeyAlgMatching(candidates, *keys[hint])) {
+    ++*keys_tried;
+    Status status = verifySignatureWithKey(candidates, *keys[hint],
+                                           jwt.signature_, signed_data,
+                                           context);
+    if (status != Status::JwtVerificationFail) {
+      return status;
+    }
+  } else {
+    hint = Jwks::kNoKeyHint;
+  }
+
+  size_t verified_key = Jwks::kNoKeyHint;
+  Status status = verifySignature(candidates, jwt.signature_, signed_data,
+                                  context, hint, &verified_key, keys_tried);
+  if (status == Status::Ok && keys.size() > 1) {
+    jwks.setKeyHint(jwt.iss_, jwt.kid_, jwt.alg_, verified_key);
+  }
+  return status;
+}
+
+// Same as verifyJwtSignature, reporting the keys tried and a failure to the
+// installed VerifyStats.
+template <typename Candidates, typename JwtType>
+Status verifyJwtSignatureWithStats(const Candidates& candidates,
+                                   const JwtType& jwt,
+                                   absl::string_view signed_data,
+                                   const Jwks& jwks, VerifyContext& context) {
+  VerifyStats* stats = verifyStats();
+  size_t keys_tried = 0;
+  Status status = verifyJwtSignature(candidates, jwt, signed_data, jwks,
+                                     context, &keys_tried);
+  if (stats != nullptr) {
+    stats->onKeysTried(keys_tried);
+  }
+  return reportFailure(stats, status);
+}
+
+// The candidate keys of a token verified by ParallelVerifier. The calling
+// thread and the executor tasks take the keys in order from next, so the
+// calling thread tries all of them if the tasks don't run. It only waits for
+// the keys taken by a task, the tasks taking no key don't touch the token or
+// the keyset, so they may run after the verification returned.
+struct ParallelKeys {
+  ParallelKeys(const KeyCandidates& candidates, std::vector<size_t> order,
+               absl::string_view signature, absl::string_view signed_data)
+      : candidates(candidates),
+        order(std::move(order)),
+        signature(signature),
+        signed_data(signed_data),
+        results(this->order.size(), Status::JwtVerificationFail),
+        first_verified(this->order.size()) {}
+
+  // Try the keys not taken yet. A key is skipped once an earlier key in order
+  // verified the token or failed with another status, as it can't change the
+  // result.
+  void run(VerifyContext& context) {
+    for (;;) {
+      const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= order.size()) {
+        return;
+      }
+      if (i < first_verified.load(std::memory_order_relaxed)) {
+        tried.fetch_add(1, std::memory_order_relaxed);
+        results[i] = verifySignatureWithKey(candidates,
+                                            *(*candidates.keys)[order[i]],
+                                            signature, signed_data, context);
+        if (results[i] != Status::JwtVerificationFail) {
+          size_t first = first_verified.load(std::memory_order_relaxed);
+          while (i < first && !first_verified.compare_exchange_weak(
+                                  first, i, std::memory_order_relaxed)) {
+          }
+        }
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (++finished == order.size()) {
+        done.notify_all();
+      }
+    }
+  }
+
+  const KeyCandidates& candidates;
+  // The indexes in candidates.keys of the keys to try.
+  const std::vector<size_t> order;
+  const absl::string_view signature;
+  const absl::string_view signed_data;
+  std::vector<Status> results;
+  std::atomic<size_t> next{0};
+  // The first key in order not failing with JwtVerificationFail.
+  std::atomic<size_t> first_verified;
+  std::atomic<size_t> tried{0};
+  std::mutex mutex;
+  std::condition_variable done;
+  // The keys tried or skipped, guarded by mutex.
+  size_t finished = 0;
+};
+
+// The tasks of verifyJwtBatch, each verifies tokens with the same kid and alg.
+// As for ParallelKeys, the calling thread and the executor tasks take the
+// tasks in order from next, and the calling thread only waits for the tasks
+// taken by another thread.
+struct BatchTasks {
+  struct Task {
+    KeyCandidates candidates;
+    const size_t* begin;
+    const size_t* end;
+  };
+
+  BatchTasks(absl::Span<const Jwt* const> jwts, absl::Span<Status> out,
+             VerifyStats* stats)
+      : jwts(jwts), out(out), stats(stats) {}
+
+  // Run the tasks not taken yet.
+  void run(VerifyContext& context) {
+    for (;;) {
+      const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+      if (i >= tasks.size()) {
+        return;
+      }
+      runTask(tasks[i], context);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (++finished == tasks.size()) {
+        done.notify_all();
+      }
+    }
+  }
+
+  void runTask(const Task& task, VerifyContext& context) {
+    BatchHmacContexts batch_hmac;
+    KeyCandidates candidates = task.candidates;
+    candidates.batch_hmac = &batch_hmac;
+    for (const size_t* i = task.begin; i != task.end; ++i) {
+      const Jwt& jwt = *jwts[*i];
+      size_t keys_tried = 0;
+      out[*i] =
+          verifySignature(candidates, jwt.signature_, jwt.signedData(),
+                          context, Jwks::kNoKeyHint, nullptr, &keys_tried);
+      if (stats != nullptr) {
+        stats->onKeysTried(keys_tried);
+      }
+    }
+  }
+
+  const absl::Span<const Jwt* const> jwts;
+  const absl::Span<Status> out;
+  VerifyStats* const stats;
+  std::vector<Task> tasks;
+  std::atomic<size_t> next{0};
+  std::mutex mutex;
+  std::condition_variable done;
+  // The tasks run, guarded by mutex.
+  size_t finished = 0;
+};
+
+}  // namespace
+
+Status verifyJwtWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks) {
+  VerifyContext context;
+  return verifyJwtWithoutTimeChecking(jwt, jwks, context);
+}
+
+Status verifyJwtWithoutTimeChecking(const Jwt& jwt, const Jwks& jwks,
+                                    VerifyContext& context) {
+  // Verify signature
+  return verifyJwtSignatureWithStats(resolveKeys(jwks, jwt.kid_, jwt.alg_),
+                                     jwt, jwt.signedData(), jwks, context);
+}
+
+Status verifyJwtWithoutTimeChecking(const JwtView& jwt, const Jwks& jwks) {
+  VerifyContext context;
+  return verifyJwtWithoutTimeChecking(jwt, jwks, context);
+}
+
+Status verifyJwtWithoutTimeChecking(const JwtView& jwt, const Jwks& jwks,
+                                    VerifyContext& context) {
+  // The signed data is verified in place in the caller's buffer.
+  return verifyJwtSignatureWithStats(resolveKeys(jwks, jwt.kid_, jwt.alg_),
+                                     jwt, jwt.signed_data_, jwks, context);
+}
+
 Status verifyJwt(const Jwt& jwt, const Jwks& jwks) {
   return verifyJwt(jwt, jwks, absl::ToUnixSeconds(absl::Now()));
 }
 
 Status verifyJwt(const Jwt& jwt, const Jwks& jwks, uint64_t now,
                  uint64_t clock_skew) {
+  VerifyContext context;
+  return verifyJwt(jwt, jwks, now, clock_skew, context);
+}
+
+Status verifyJwt(const Jwt& jwt, const Jwks& jwks, uint64_t now,
+                 uint64_t clock_skew, VerifyContext& context) {
   Status time_status = jwt.verifyTimeConstraint(now, clock_skew);
   if (time_status != Status::Ok) {
-    return time_status;
+    return reportFailure(verifyStats(), time_status);
+  }
+
+  return verifyJwtWithoutTimeChecking(jwt, jwks, context);
+}
+
+Status verifyJwt(const JwtView& jwt, const Jwks& jwks, uint64_t now,
+                 uint64_t clock_skew) {
+  VerifyContext context;
+  return verifyJwt(jwt, jwks, now, clock_skew, context);
+}
+
+Status verifyJwt(const JwtView& jwt, const Jwks& jwks, uint64_t now,
+                 uint64_t clock_skew, VerifyContext& context) {
+  Status time_status = jwt.verifyTimeConstraint(now, clock_skew);
+  if (time_status != Status::Ok) {
+    return reportFailure(verifyStats(), time_status);
+  }
+
+  return verifyJwtWithoutTimeChecking(jwt, jwks, context);
+}
+
+void verifyJwtBatch(absl::Span<const Jwt* const> jwts, const Jwks& jwks,
+                    uint64_t now, absl::Span<Status> out,
+                    const Executor& executor, uint64_t clock_skew) {
+  assert(out.size() == jwts.size());
+
+  // Indices of the tokens to verify, by kid and alg.
+  absl::flat_hash_map<std::pair<absl::string_view, absl::string_view>,
+                      std::vector<size_t>>
+      groups;
+  for (size_t i = 0; i < jwts.size(); ++i) {
+    const Jwt& jwt = *jwts[i];
+    out[i] = jwt.verifyTimeConstraint(now, clock_skew);
+    if (out[i] == Status::Ok) {
+      groups[{jwt.kid_, jwt.alg_}].push_back(i);
+    }
+  }
+
+  // Large groups are split so that they can be verified in parallel. The
+  // state is shared with the executor tasks, which may run after it returns.
+  constexpr size_t kMaxTokensPerTask = 16;
+  VerifyStats* stats = verifyStats();
+  auto batch = std::make_shared<BatchTasks>(jwts, out, stats);
+  for (const auto& group : groups) {
+    const KeyCandidates candidates =
+        resolveKeys(jwks, group.first.first, group.first.second);
+    const std::vector<size_t>& indices = group.second;
+    for (size_t i = 0; i < indices.size(); i += kMaxTokensPerTask) {
+      batch->tasks.push_back(
+          {candidates, indices.data() + i,
+           indices.data() + std::min(i + kMaxTokensPerTask, indices.size())});
+    }
   }
 
-  return verifyJwtWithoutTimeChecking(jwt, jwks);
+  // The calling thread runs tasks too, so that the batch completes even if
+  // the executor runs its tasks on the threads waiting here, or drops them.
+  const size_t num_tasks = batch->tasks.size();
+  if (executor) {
+    for (size_t i = 1; i < num_tasks; ++i) {
+      executor([batch]() {
+        VerifyContext context;
+        batch->run(context);
+      });
+    }
+  }
+  VerifyContext context;
+  batch->run(context);
+  {
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [&batch, num_tasks]() {
+      return batch->finished == num_tasks;
+    });
+  }
+
+  for (Status status : out) {
+    reportFailure(stats, status);
+  }
 }
 
 Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
@@ -320,12 +927,236 @@ Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
 
 Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
                  const std::vector<std::string>& audiences, uint64_t now) {
-  CheckAudience checker(audiences);
-  if (!checker.areAudiencesAllowed(jwt.audiences_)) {
-    return Status::JwtAudienceNotAllowed;
+  return verifyJwt(jwt, jwks, CheckAudience(audiences), now);
+}
+
+Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
+                 const CheckAudience& audiences) {
+  return verifyJwt(jwt, jwks, audiences, absl::ToUnixSeconds(absl::Now()));
+}
+
+Status verifyJwt(const Jwt& jwt, const Jwks& jwks,
+                 const CheckAudience& audiences, uint64_t now) {
+  if (!audiences.areAudiencesAllowed(jwt.audiences_)) {
+    return reportFailure(verifyStats(), Status::JwtAudienceNotAllowed);
   }
   return verifyJwt(jwt, jwks, now);
 }
 
+StagedVerifier::StagedVerifier(const Options& options)
+    : issuers_(options.issuers.begin(), options.issuers.end()),
+      audiences_(options.audiences),
+      clock_skew_(options.clock_skew),
+      claims_check_(options.claims_check) {}
+
+Status StagedVerifier::verify(absl::string_view token, const Jwks& jwks,
+                              uint64_t now, JwtView* jwt) const {
+  VerifyContext context;
+  return verify(token, jwks, now, jwt, context);
+}
+
+Status StagedVerifier::verify(absl::string_view token, const Jwks& jwks,
+                              uint64_t now, JwtView* jwt,
+                              VerifyContext& context) const {
+  Status status = jwt->parseClaimsFromString(token);
+  if (status != Status::Ok) {
+    return status;
+  }
+
+  VerifyStats* stats = verifyStats();
+  status = jwt->verifyTimeConstraint(now, clock_skew_);
+  if (status != Status::Ok) {
+    return reportFailure(stats, status);
+  }
+  if (!issuers_.empty() && issuers_.find(jwt->iss_) == issuers_.end()) {
+    return reportFailure(stats, Status::JwtUnknownIssuer);
+  }
+  if (!audiences_.areAudiencesAllowed(jwt->audiences_)) {
+    return reportFailure(stats, Status::JwtAudienceNotAllowed);
+  }
+  if (claims_check_) {
+    status = claims_check_(*jwt);
+    if (status != Status::Ok) {
+      return reportFailure(stats, status);
+    }
+  }
+
+  const KeyCandidates candidates = resolveKeys(jwks, jwt->kid_, jwt->alg_);
+  if (!hasMatchingKey(candidates)) {
+    return reportFailure(stats, Status::JwksKidAlgMismatch);
+  }
+
+  status = jwt->decodeSignature();
+  if (status != Status::Ok) {
+    return status;
+  }
+  size_t keys_tried = 0;
+  status = verifySignature(candidates, jwt->signature_, jwt->signed_data_,
+                           context, Jwks::kNoKeyHint, nullptr, &keys_tried);
+  if (stats != nullptr) {
+    stats->onKeysTried(keys_tried);
+  }
+  return reportFailure(stats, status);
+}
+
+ParallelVerifier::ParallelVerifier(Executor executor, size_t min_parallel_keys)
+    : executor_(std::move(executor)), min_parallel_keys_(min_parallel_keys) {}
+
+Status ParallelVerifier::verifyWithoutTimeChecking(const Jwt& jwt,
+                                                   const Jwks& jwks) {
+  VerifyContext context;
+  return verifyWithoutTimeChecking(jwt, jwks, context);
+}
+
+Status ParallelVerifier::verifyWithoutTimeChecking(const Jwt& jwt,
+                                                   const Jwks& jwks,
+                                                   VerifyContext& context) {
+  VerifyStats* stats = verifyStats();
+  size_t keys_tried = 0;
+  Status status = verifyWithKeys(jwt, jwks, context, &keys_tried);
+  if (stats != nullptr) {
+    stats->onKeysTried(keys_tried);
+  }
+  return reportFailure(stats, status);
+}
+
+Status ParallelVerifier::verifyWithKeys(const Jwt& jwt, const Jwks& jwks,
+                                        VerifyContext& context,
+                                        size_t* keys_tried) {
+  const KeyCandidates candidates = resolveKeys(jwks, jwt.kid_, jwt.alg_);
+  const std::vector<const Jwks::Pubkey*>& keys = *candidates.keys;
+  const absl::string_view signed_data = jwt.signedData();
+
+  // The key of the hint is tried first on the calling thread, as in
+  // verifyJwtSignature.
+  size_t hint = keys.size() > 1 ? jwks.keyHint(jwt.iss_, jwt.kid_, jwt.alg_)
+                                : Jwks::kNoKeyHint;
+  if (hint < keys.size() && isKeyAlgMatching(candidates, *keys[hint])) {
+    ++*keys_tried;
+    Status status = verifySignatureWithKey(candidates, *keys[hint],
+                                           jwt.signature_, signed_data,
+                                           context);
+    if (status != Status::JwtVerificationFail) {
+      return status;
+    }
+  } else {
+    hint = Jwks::kNoKeyHint;
+  }
+
+  std::vector<size_t> order;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (i != hint && isKeyAlgMatching(candidates, *keys[i])) {
+      order.push_back(i);
+    }
+  }
+  if (!executor_ || order.size() < std::max<size_t>(min_parallel_keys_, 2)) {
+    size_t verified_key = Jwks::kNoKeyHint;
+    Status status = verifySignature(candidates, jwt.signature_, signed_data,
+                                    context, hint, &verified_key, keys_tried);
+    if (status == Status::Ok && keys.size() > 1) {
+      jwks.setKeyHint(jwt.iss_, jwt.kid_, jwt.alg_, verified_key);
+    }
+    return status;
+  }
+
+  // The calling thread tries keys too, so that the tokens are verified even
+  // if the executor runs its tasks on the threads waiting here.
+  auto parallel = std::make_shared<ParallelKeys>(
+      candidates, std::move(order), jwt.signature_, signed_data);
+  const size_t num_keys = parallel->order.size();
+  for (size_t i = 1; i < num_keys; ++i) {
+    executor_([parallel]() {
+      VerifyContext task_context;
+      parallel->run(task_context);
+    });
+  }
+  parallel->run(context);
+  {
+    std::unique_lock<std::mutex> lock(parallel->mutex);
+    parallel->done.wait(lock, [&parallel, num_keys]() {
+      return parallel->finished == num_keys;
+    });
+  }
+  *keys_tried += parallel->tried.load(std::memory_order_relaxed);
+
+  // The status of the first key in order not failing, as verifySignature.
+  const size_t first = parallel->first_verified.load();
+  if (first == num_keys) {
+    return Status::JwtVerificationFail;
+  }
+  Status status = parallel->results[first];
+  if (status == Status::Ok) {
+    jwks.setKeyHint(jwt.iss_, jwt.kid_, jwt.alg_, parallel->order[first]);
+  }
+  return status;
+}
+
+Status ParallelVerifier::verify(const Jwt& jwt, const Jwks& jwks, uint64_t now,
+                                uint64_t clock_skew) {
+  Status time_status = jwt.verifyTimeConstraint(now, clock_skew);
+  if (time_status != Status::Ok) {
+    return reportFailure(verifyStats(), time_status);
+  }
+  return verifyWithoutTimeChecking(jwt, jwks);
+}
+
+template <Jwks::Algorithm Alg>
+Verifier<Alg>::Verifier(uint64_t clock_skew) : clock_skew_(clock_skew) {}
+
+template <Jwks::Algorithm Alg>
+Status Verifier<Alg>::verify(absl::string_view token, const Jwks& jwks,
+                             uint64_t now, JwtView* jwt) const {
+  VerifyContext context;
+  return verify(token, jwks, now, jwt, context);
+}
+
+template <Jwks::Algorithm Alg>
+Status Verifier<Alg>::verify(absl::string_view token, const Jwks& jwks,
+                             uint64_t now, JwtView* jwt,
+                             VerifyContext& context) const {
+  Status status = jwt->parseFromStringForAlg(token, algName(Alg));
+  if (status != Status::Ok) {
+    return status;
+  }
+  status = jwt->verifyTimeConstraint(now, clock_skew_);
+  if (status != Status::Ok) {
+    return reportFailure(verifyStats(), status);
+  }
+  return verifyJwtSignatureWithStats(resolveKeys<Alg>(jwks, jwt->kid_), *jwt,
+                                     jwt->signed_data_, jwks, context);
+}
+
+template <Jwks::Algorithm Alg>
+Status Verifier<Alg>::verifyWithoutTimeChecking(const Jwt& jwt,
+                                                const Jwks& jwks) const {
+  VerifyContext context;
+  return verifyWithoutTimeChecking(jwt, jwks, context);
+}
+
+template <Jwks::Algorithm Alg>
+Status Verifier<Alg>::verifyWithoutTimeChecking(const Jwt& jwt,
+                                                const Jwks& jwks,
+                                                VerifyContext& context) const {
+  if (jwt.alg_ != algName(Alg)) {
+    return reportFailure(verifyStats(), Status::JwksKidAlgMismatch);
+  }
+  return verifyJwtSignatureWithStats(resolveKeys<Alg>(jwks, jwt.kid_), jwt,
+                                     jwt.signedData(), jwks, context);
+}
+
+template class Verifier<Jwks::Algorithm::RS256>;
+template class Verifier<Jwks::Algorithm::RS384>;
+template class Verifier<Jwks::Algorithm::RS512>;
+template class Verifier<Jwks::Algorithm::PS256>;
+template class Verifier<Jwks::Algorithm::PS384>;
+template class Verifier<Jwks::Algorithm::PS512>;
+template class Verifier<Jwks::Algorithm::ES256>;
+template class Verifier<Jwks::Algorithm::ES384>;
+template class Verifier<Jwks::Algorithm::ES512>;
+template class Verifier<Jwks::Algorithm::HS256>;
+template class Verifier<Jwks::Algorithm::HS384>;
+template class Verifier<Jwks::Algorithm::HS512>;
+template class Verifier<Jwks::Algorithm::EdDSA>;
+
 }  // namespace jwt_verify
 }  // namespace google
@@ -0,0 +1,54 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/verify_context.h"
+
+#include "openssl/err.h"
+
+namespace google {
+namespace jwt_verify {
+
+EVP_MD_CTX* VerifyContext::mdCtx() {
+  if (md_ctx_ == nullptr) {
+    md_ctx_.reset(EVP_MD_CTX_create());
+  } else {
+    // Frees the EVP_PKEY_CTX of a previous verification, if any.
+    EVP_MD_CTX_reset(md_ctx_.get());
+  }
+  return md_ctx_.get();
+}
+
+ECDSA_SIG* VerifyContext::ecdsaSig() {
+  if (ecdsa_sig_ == nullptr) {
+    ecdsa_sig_.reset(ECDSA_SIG_new());
+  }
+  return ecdsa_sig_.get();
+}
+
+HMAC_CTX* VerifyContext::hmacCtx(const HMAC_CTX* key_template) {
+  if (hmac_ctx_ == nullptr) {
+    hmac_ctx_.reset(HMAC_CTX_new());
+    if (hmac_ctx_ == nullptr) {
+      return nullptr;
+    }
+  }
+  if (HMAC_CTX_copy_ex(hmac_ctx_.get(), key_template) != 1) {
+    ERR_clear_error();
+    return nullptr;
+  }
+  return hmac_ctx_.get();
+}
+
+}  // namespace jwt_verify
+}  // namespace google
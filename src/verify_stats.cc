@@ -0,0 +1,67 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/verify_stats.h"
+
+namespace google {
+namespace jwt_verify {
+
+namespace stats_internal {
+std::atomic<VerifyStats*> verify_stats{nullptr};
+}  // namespace stats_internal
+
+constexpr size_t VerifyStats::kNumStages;
+constexpr size_t VerifyCounters::kNumStatuses;
+
+void setVerifyStats(VerifyStats* stats) {
+  stats_internal::verify_stats.store(stats, std::memory_order_release);
+}
+
+void VerifyCounters::onStage(Stage stage, std::chrono::nanoseconds duration) {
+  const size_t i = static_cast<size_t>(stage);
+  stage_counts_[i].fetch_add(1, std::memory_order_relaxed);
+  stage_nanos_[i].fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+void VerifyCounters::onKeysTried(size_t keys) {
+  verified_tokens_.fetch_add(1, std::memory_order_relaxed);
+  keys_tried_.fetch_add(keys, std::memory_order_relaxed);
+}
+
+void VerifyCounters::onCacheLookup(bool hit) {
+  (hit ? cache_hits_ : cache_misses_).fetch_add(1, std::memory_order_relaxed);
+}
+
+void VerifyCounters::onFailure(Status status) {
+  const size_t i = static_cast<size_t>(status);
+  if (i < kNumStatuses) {
+    failures_[i].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+uint64_t VerifyCounters::stageCount(Stage stage) const {
+  return load(stage_counts_[static_cast<size_t>(stage)]);
+}
+
+uint64_t VerifyCounters::stageNanos(Stage stage) const {
+  return load(stage_nanos_[static_cast<size_t>(stage)]);
+}
+
+uint64_t VerifyCounters::failures(Status status) const {
+  const size_t i = static_cast<size_t>(status);
+  return i < kNumStatuses ? load(failures_[i]) : 0;
+}
+
+}  // namespace jwt_verify
+}  // namespace google
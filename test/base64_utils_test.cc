@@ -0,0 +1,110 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/base64_utils.h"
+
+#include "absl/strings/escaping.h"
+#include "gtest/gtest.h"
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+// Some bytes and their base64url encoding, long enough for several blocks.
+std::string encodedBytes(size_t len) {
+  std::string bytes(len, '\0');
+  for (size_t i = 0; i < len; ++i) {
+    bytes[i] = static_cast<char>(i * 37 + 11);
+  }
+  std::string encoded;
+  absl::WebSafeBase64Escape(bytes, &encoded);
+  return encoded;
+}
+
+void expectSameAsAbsl(const std::string& in) {
+  std::string expected;
+  const bool expected_ok = absl::WebSafeBase64Unescape(in, &expected);
+  std::string out;
+  EXPECT_EQ(base64UrlDecode(in, &out), expected_ok) << in;
+  EXPECT_EQ(out, expected_ok ? expected : "") << in;
+}
+
+TEST(Base64UtilsTest, Decode) {
+  std::string out;
+  EXPECT_TRUE(base64UrlDecode("", &out));
+  EXPECT_EQ(out, "");
+  EXPECT_TRUE(base64UrlDecode("YQ", &out));
+  EXPECT_EQ(out, "a");
+  EXPECT_TRUE(base64UrlDecode("YQ==", &out));
+  EXPECT_EQ(out, "a");
+  EXPECT_TRUE(base64UrlDecode("YWI", &out));
+  EXPECT_EQ(out, "ab");
+  EXPECT_TRUE(base64UrlDecode("YWI=", &out));
+  EXPECT_EQ(out, "ab");
+  EXPECT_TRUE(base64UrlDecode("YWJj", &out));
+  EXPECT_EQ(out, "abc");
+  EXPECT_TRUE(base64UrlDecode("-_8", &out));
+  EXPECT_EQ(out, "\xfb\xff");
+  EXPECT_TRUE(base64UrlDecode(" Y W\nJj\t", &out));
+  EXPECT_EQ(out, "abc");
+}
+
+TEST(Base64UtilsTest, DecodeErrors) {
+  std::string out = "previous";
+  EXPECT_FALSE(base64UrlDecode("Y", &out));
+  EXPECT_EQ(out, "");
+  EXPECT_FALSE(base64UrlDecode("YQ=", &out));
+  EXPECT_FALSE(base64UrlDecode("YQ===", &out));
+  EXPECT_FALSE(base64UrlDecode("YWJj=", &out));
+  EXPECT_FALSE(base64UrlDecode("YQ==YQ==", &out));
+  // Not the url alphabet.
+  EXPECT_FALSE(base64UrlDecode("+/8", &out));
+  EXPECT_FALSE(base64UrlDecode("YW\x80j", &out));
+}
+
+TEST(Base64UtilsTest, DecodeIntoBuffer) {
+  const std::string encoded = encodedBytes(100);
+  std::string expected;
+  ASSERT_TRUE(absl::WebSafeBase64Unescape(encoded, &expected));
+
+  std::string buffer(base64UrlDecodedMaxSize(encoded.size()), '\0');
+  size_t len = 0;
+  ASSERT_TRUE(base64UrlDecode(
+      encoded, reinterpret_cast<uint8_t*>(&buffer[0]), &len));
+  EXPECT_EQ(buffer.substr(0, len), expected);
+}
+
+TEST(Base64UtilsTest, SameAsAbsl) {
+  for (size_t len = 0; len < 200; ++len) {
+    const std::string encoded = encodedBytes(len);
+    expectSameAsAbsl(encoded);
+    // A character of each position replaced, in and out of the blocks.
+    for (size_t i = 0; i < encoded.size(); i += 7) {
+      for (char c : {'=', '.', ' ', '\n', '+', '/', '\0', '\xff'}) {
+        std::string changed = encoded;
+        changed[i] = c;
+        expectSameAsAbsl(changed);
+      }
+    }
+    expectSameAsAbsl(encoded + "=");
+    expectSameAsAbsl(encoded + "==");
+    expectSameAsAbsl(encoded + "..");
+    expectSameAsAbsl(encoded + " = =\n");
+    expectSameAsAbsl(encoded + "=A");
+  }
+}
+
+}  // namespace
+}  // namespace jwt_verify
+}  // namespace google
@@ -90,6 +90,14 @@ TEST(CheckAudienceTest, TestEmptyAudienceMatch) {
   EXPECT_TRUE(checker.areAudiencesAllowed({""}));
 }
 
+TEST(CheckAudienceTest, TestOnlySchemeOrSlashMatchEmpty) {
+  CheckAudience checker({""});
+  EXPECT_TRUE(checker.areAudiencesAllowed({"http://"}));
+  EXPECT_TRUE(checker.areAudiencesAllowed({"https://"}));
+  EXPECT_TRUE(checker.areAudiencesAllowed({"/"}));
+  EXPECT_FALSE(checker.areAudiencesAllowed({"//"}));
+}
+
 }  // namespace
 }  // namespace jwt_verify
 }  // namespace google
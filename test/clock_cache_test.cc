@@ -0,0 +1,139 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+//
+// Tests for ClockCache
+
+#include "simple_lru_cache/clock_cache.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace google {
+namespace simple_lru_cache {
+namespace {
+
+typedef ClockCache<int, std::string> TestCache;
+
+std::shared_ptr<const std::string> makeValue(int i) {
+  return std::make_shared<const std::string>(std::to_string(i));
+}
+
+TEST(ClockCacheTest, InsertLookupRemove) {
+  TestCache cache(10);
+  for (int i = 0; i < 10; ++i) {
+    cache.insert(i, makeValue(i));
+  }
+  EXPECT_EQ(cache.entries(), 10);
+  for (int i = 0; i < 10; ++i) {
+    auto value = cache.lookup(i);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, std::to_string(i));
+  }
+  EXPECT_EQ(cache.lookup(10), nullptr);
+
+  // A value outlives its entry.
+  auto value = cache.lookup(3);
+  cache.remove(3);
+  EXPECT_EQ(cache.lookup(3), nullptr);
+  EXPECT_EQ(*value, "3");
+  EXPECT_EQ(cache.entries(), 9);
+
+  cache.remove(3);
+  EXPECT_EQ(cache.entries(), 9);
+
+  cache.clear();
+  EXPECT_EQ(cache.entries(), 0);
+  EXPECT_EQ(cache.lookup(0), nullptr);
+}
+
+TEST(ClockCacheTest, InsertReplaces) {
+  TestCache cache(2);
+  cache.insert(1, makeValue(1));
+  cache.insert(1, makeValue(2));
+  EXPECT_EQ(cache.entries(), 1);
+  EXPECT_EQ(*cache.lookup(1), "2");
+
+  cache.insert(1, nullptr);
+  EXPECT_EQ(cache.lookup(1), nullptr);
+  EXPECT_EQ(cache.entries(), 0);
+}
+
+TEST(ClockCacheTest, EvictsUnreferencedEntries) {
+  TestCache cache(4);
+  for (int i = 0; i < 4; ++i) {
+    cache.insert(i, makeValue(i));
+  }
+  // The first eviction clears all the bits set by insert, then evicts key 0
+  // unless it was looked up again.
+  cache.insert(4, makeValue(4));
+  EXPECT_EQ(cache.entries(), 4);
+  EXPECT_EQ(cache.lookup(0), nullptr);
+
+  // Keys looked up since the hand passed them are skipped, key 2 is not.
+  ASSERT_NE(cache.lookup(1), nullptr);
+  ASSERT_NE(cache.lookup(3), nullptr);
+  cache.insert(5, makeValue(5));
+  EXPECT_EQ(cache.entries(), 4);
+  EXPECT_EQ(cache.lookup(2), nullptr);
+  EXPECT_NE(cache.lookup(1), nullptr);
+  EXPECT_NE(cache.lookup(3), nullptr);
+  EXPECT_NE(cache.lookup(4), nullptr);
+  EXPECT_NE(cache.lookup(5), nullptr);
+}
+
+TEST(ClockCacheTest, ManyRemovals) {
+  // Removed entries are reclaimed so lookups of absent keys terminate.
+  TestCache cache(8);
+  for (int i = 0; i < 10000; ++i) {
+    cache.insert(i, makeValue(i));
+    if (i % 3 == 0) {
+      cache.remove(i);
+    }
+    EXPECT_LE(cache.entries(), 8);
+  }
+  EXPECT_EQ(cache.lookup(-1), nullptr);
+  EXPECT_EQ(*cache.lookup(9998), "9998");
+}
+
+TEST(ClockCacheTest, ConcurrentAccess) {
+  TestCache cache(500);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 2000; ++i) {
+        const int key = (t * 2000 + i) % 700;
+        auto value = cache.lookup(key);
+        if (value == nullptr) {
+          cache.insert(key, makeValue(key));
+        } else {
+          EXPECT_EQ(*value, std::to_string(key));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(cache.entries(), 500);
+}
+
+}  // namespace
+}  // namespace simple_lru_cache
+}  // namespace google
@@ -0,0 +1,339 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/json_scanner.h"
+
+#include "google/protobuf/struct.pb.h"
+#include "google/protobuf/util/json_util.h"
+#include "google/protobuf/util/message_differencer.h"
+#include "gtest/gtest.h"
+
+using ::google::protobuf::ListValue;
+using ::google::protobuf::Struct;
+using ::google::protobuf::Value;
+using ::google::protobuf::util::MessageDifferencer;
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+bool readValue(JsonScanner* scanner, JsonScanner::Token token, Value* value);
+
+bool readObject(JsonScanner* scanner, Struct* struct_pb) {
+  for (;;) {
+    JsonScanner::Token token = scanner->next();
+    if (token == JsonScanner::EndObject) {
+      return true;
+    }
+    if (token != JsonScanner::Key) {
+      return false;
+    }
+    Value& value = (*struct_pb->mutable_fields())[std::string(scanner->str())];
+    if (!readValue(scanner, scanner->next(), &value)) {
+      return false;
+    }
+  }
+}
+
+bool readValue(JsonScanner* scanner, JsonScanner::Token token, Value* value) {
+  switch (token) {
+    case JsonScanner::BeginObject:
+      return readObject(scanner, value->mutable_struct_value());
+    case JsonScanner::BeginArray: {
+      ListValue* list = value->mutable_list_value();
+      for (token = scanner->next(); token != JsonScanner::EndArray;
+           token = scanner->next()) {
+        if (!readValue(scanner, token, list->add_values())) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case JsonScanner::String:
+      value->set_string_value(std::string(scanner->str()));
+      return true;
+    case JsonScanner::Number:
+      value->set_number_value(scanner->number());
+      return true;
+    case JsonScanner::Bool:
+      value->set_bool_value(scanner->boolean());
+      return true;
+    case JsonScanner::Null:
+      value->set_null_value(::google::protobuf::NULL_VALUE);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Builds a Struct from the tokens of the scanner.
+bool scanToStruct(const std::string& json, Struct* struct_pb) {
+  JsonScanner scanner(json);
+  return scanner.next() == JsonScanner::BeginObject &&
+         readObject(&scanner, struct_pb) &&
+         scanner.next() == JsonScanner::End;
+}
+
+// Expects the scanner to accept json if and only if JsonStringToMessage does,
+// and to read the same values.
+void expectSameAsStruct(const std::string& json) {
+  Struct expected;
+  const bool expected_ok =
+      ::google::protobuf::util::JsonStringToMessage(json, &expected).ok();
+  Struct actual;
+  EXPECT_EQ(scanToStruct(json, &actual), expected_ok) << json;
+  if (expected_ok) {
+    EXPECT_TRUE(MessageDifferencer::Equals(actual, expected)) << json;
+  }
+}
+
+std::string nestedObjects(int count, const std::string& leaf) {
+  std::string json;
+  for (int i = 0; i < count; ++i) {
+    json += "{\"a\":";
+  }
+  json += leaf;
+  json += std::string(count, '}');
+  return json;
+}
+
+std::string nestedArrays(int count, const std::string& leaf) {
+  return "{\"a\":" + std::string(count, '[') + leaf + std::string(count, ']') +
+         "}";
+}
+
+TEST(JsonScannerTest, Tokens) {
+  JsonScanner scanner(
+      R"({"s":"v", "n":-1.5e2, "b":true, "z":null, "a":[{}, false]})");
+  EXPECT_EQ(scanner.next(), JsonScanner::BeginObject);
+  EXPECT_EQ(scanner.depth(), 1u);
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.str(), "s");
+  EXPECT_EQ(scanner.next(), JsonScanner::String);
+  EXPECT_EQ(scanner.str(), "v");
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.next(), JsonScanner::Number);
+  EXPECT_EQ(scanner.number(), -150);
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.next(), JsonScanner::Bool);
+  EXPECT_TRUE(scanner.boolean());
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.next(), JsonScanner::Null);
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.str(), "a");
+  EXPECT_EQ(scanner.next(), JsonScanner::BeginArray);
+  EXPECT_EQ(scanner.depth(), 2u);
+  EXPECT_EQ(scanner.next(), JsonScanner::BeginObject);
+  EXPECT_EQ(scanner.depth(), 3u);
+  EXPECT_EQ(scanner.next(), JsonScanner::EndObject);
+  EXPECT_EQ(scanner.next(), JsonScanner::Bool);
+  EXPECT_FALSE(scanner.boolean());
+  EXPECT_EQ(scanner.next(), JsonScanner::EndArray);
+  EXPECT_EQ(scanner.next(), JsonScanner::EndObject);
+  EXPECT_EQ(scanner.depth(), 0u);
+  EXPECT_EQ(scanner.next(), JsonScanner::End);
+  EXPECT_EQ(scanner.next(), JsonScanner::End);
+}
+
+TEST(JsonScannerTest, SkipValue) {
+  JsonScanner scanner(R"({"a":{"b":[1,{"c":2}]},"d":3})");
+  EXPECT_EQ(scanner.next(), JsonScanner::BeginObject);
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_TRUE(scanner.skipValue(scanner.next()));
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.str(), "d");
+  EXPECT_TRUE(scanner.skipValue(scanner.next()));
+  EXPECT_EQ(scanner.next(), JsonScanner::EndObject);
+  EXPECT_EQ(scanner.next(), JsonScanner::End);
+
+  JsonScanner bad(R"({"a":[1,}]})");
+  EXPECT_EQ(bad.next(), JsonScanner::BeginObject);
+  EXPECT_EQ(bad.next(), JsonScanner::Key);
+  EXPECT_FALSE(bad.skipValue(bad.next()));
+  EXPECT_EQ(bad.next(), JsonScanner::Error);
+}
+
+TEST(JsonScannerTest, StringNotCopiedWithoutEscapes) {
+  const std::string json = R"({"key":"value"})";
+  JsonScanner scanner(json);
+  EXPECT_EQ(scanner.next(), JsonScanner::BeginObject);
+  EXPECT_EQ(scanner.next(), JsonScanner::Key);
+  EXPECT_EQ(scanner.str().data(), json.data() + 2);
+  EXPECT_EQ(scanner.next(), JsonScanner::String);
+  EXPECT_EQ(scanner.str().data(), json.data() + 8);
+}
+
+TEST(JsonScannerTest, SameAsStructForValidJson) {
+  for (const std::string json : {
+           R"({})",
+           R"( { } )",
+           "\t\n\v\f\r{\"a\":1}\r\n",
+           R"({"":1})",
+           R"({"a":"b","c":[1,"2",true,false,null,{},[]],"d":{"e":{}}})",
+           R"({"a":{"b":1},"c":{"b":2}})",
+           R"({"iss":"https://example.com","aud":["a","b"],"exp":1501281058})",
+       }) {
+    expectSameAsStruct(json);
+  }
+}
+
+TEST(JsonScannerTest, SameAsStructForLenientJson) {
+  for (const std::string json : {
+           R"({'a':'b'})",
+           R"({"a":'x"y'})",
+           R"({a:1,_b:2,$c3:3,nullx:4,truex:5})",
+           R"({"a":1,})",
+           R"({"a":[1,2,],"b":{},})",
+           R"({"a":"\x\'\/\U00e9"})",
+           "{\"a\":\"\t\x01\x7f\"}",
+           "{\"a\":\"\\\xc3\xa9\"}",
+       }) {
+    expectSameAsStruct(json);
+  }
+}
+
+TEST(JsonScannerTest, SameAsStructForInvalidJson) {
+  for (const std::string json : {
+           "",
+           "   ",
+           R"([1])",
+           R"("a")",
+           R"(null)",
+           R"({"a":1}x)",
+           R"({"a":1}{})",
+           R"({"a":1)",
+           R"({"a")",
+           R"({"a":)",
+           R"({"a":})",
+           R"({"a" 1})",
+           R"({"a",1})",
+           R"({"a":1 "b":2})",
+           R"({"a":1,,"b":2})",
+           R"({,"a":1})",
+           R"({"a":[,1]})",
+           R"({"a":[1,,2]})",
+           R"({"a":[1 2]})",
+           R"({"a":1,"a":2})",
+           R"({"a":null,"a":1})",
+           R"({"a":{"b":1,"b":2}})",
+           R"({"a":[{"b":1,"b":1}]})",
+           R"({"a":1,"b":{},"a":2})",
+           R"({true:1})",
+           R"({false:1})",
+           R"({null:1})",
+           R"({1a:1})",
+           R"({a-b:1})",
+           R"({"a":True})",
+           R"({"a":tru})",
+           R"({"a":truex})",
+           R"({"a":nul})",
+           R"({"a":NaN})",
+           R"({"a":Infinity})",
+           R"({"a":b})",
+           R"({"a": 1 /*c*/})",
+           R"({"a":1}//x)",
+           R"({"a":'x"})",
+           R"({"a":"x)",
+           "{\"a\":\"\\",
+           "\xef\xbb\xbf{}",
+       }) {
+    expectSameAsStruct(json);
+  }
+}
+
+TEST(JsonScannerTest, SameAsStructForNumbers) {
+  for (const std::string number : {
+           "0",     "-0",      "1",      "-1",      "10",
+           "0.0",   "1.",      "-1.",    "-.5",     "00.5",
+           "01.5",  "01e1",    "1e5",    "1E-5",    "1e+5",
+           "1.e5",  "0e5",     "1e05",   "-1.5e3",  "1e-400",
+           "1e308", "4.9e-324",
+           "18446744073709551616",
+           "-9223372036854775809",
+           "1.7976931348623157e308",
+           "1.7976931348623159e308",
+           "1e400", "-1e400",  ".5",     "00",      "01",
+           "-00",   "-01",     "0x10",   "0-1",     "+1",
+           "-",     "--1",     "-.",     "- 1",     "-e1",
+           "1e",    "1e-",     "1E+",    "1.e",     "1.5e+",
+           "1.5.5", "1..",     "1e5e5",  "1+2",     "1-1",
+           "1-",
+       }) {
+    expectSameAsStruct("{\"a\":" + number + "}");
+  }
+}
+
+TEST(JsonScannerTest, SameAsStructForStrings) {
+  for (const std::string str : {
+           R"("\"\\\/\b\f\n\r\t")",
+           R"("\u0000")",
+           R"("é€")",
+           R"("😀")",
+           R"("􏿿")",
+           R"("￿")",
+           R"("\uDE00")",
+           R"("\ud83d")",
+           R"("\ud83dx")",
+           R"("\ud83d\")",
+           R"("\ud83d\n")",
+           R"("\ud83dA")",
+           R"("\ud83d\ud83d")",
+           R"("\ud83d\uDE0")",
+           R"("\uzzzz")",
+           R"("\u12")",
+           R"("\u0")",
+           "\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"",
+           "\"\xff\"",
+           "\"\xc3\"",
+           "\"\xe2\x82\"",
+           "\"\xc0\x80\"",
+           "\"\xe0\x80\x80\"",
+           "\"\xed\xa0\x80\"",
+           "\"\xf4\x90\x80\x80\"",
+           "\"\xf5\x80\x80\x80\"",
+       }) {
+    expectSameAsStruct("{\"a\":" + str + "}");
+    expectSameAsStruct("{" + str + ":1}");
+  }
+}
+
+TEST(JsonScannerTest, SameAsStructForNesting) {
+  for (int count : {32, 33, 34}) {
+    expectSameAsStruct(nestedObjects(count, "1"));
+    expectSameAsStruct(nestedObjects(count, "{}"));
+    expectSameAsStruct(nestedObjects(count, "[]"));
+    expectSameAsStruct(nestedObjects(count, "[1]"));
+  }
+  for (int count : {47, 48, 49, 50}) {
+    expectSameAsStruct(nestedArrays(count, "1"));
+    expectSameAsStruct(nestedArrays(count, "{}"));
+    expectSameAsStruct(nestedArrays(count, "[]"));
+    expectSameAsStruct(nestedArrays(count, R"({"b":1})"));
+  }
+  for (int count : {19, 20}) {
+    std::string json = "{\"a\":";
+    for (int i = 0; i < count; ++i) {
+      json += "[{\"a\":";
+    }
+    json += "1";
+    for (int i = 0; i < count; ++i) {
+      json += "}]";
+    }
+    expectSameAsStruct(json + "}");
+  }
+}
+
+}  // namespace
+}  // namespace jwt_verify
+}  // namespace google
@@ -0,0 +1,245 @@
+// Copyright 2018 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//    https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "jwt_verify_lib/jwks_provider.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace google {
+namespace jwt_verify {
+namespace {
+
+const std::string SymmetricKeyHMAC = R"(
+{
+  "keys": [
+    {
+      "kty": "oct",
+      "alg": "HS256",
+      "use": "sig",
+      "kid": "b3319a147514df7ee5e4bcdee51350cc890cc89e",
+      "k": "nyeGXUHngW64dyg2EuDs_8x6VGa14Bkrv1SFQwOzKfI"
+    }
+  ]
+}
+)";
+
+// SymmetricKeyHMAC with another key added.
+const std::string RotatedSymmetricKeyHMAC = R"(
+{
+  "keys": [
+    {
+      "kty": "oct",
+      "alg": "HS256",
+      "use": "sig",
+      "kid": "62a93512c9ee4c7f8067b5a216dade2763d32a47",
+      "k": "LcHQCLETtc_QO4D69zCnQEIAYaZ6BsldibDzuRHE5bI"
+    },
+    {
+      "kty": "oct",
+      "alg": "HS256",
+      "use": "sig",
+      "kid": "b3319a147514df7ee5e4bcdee51350cc890cc89e",
+      "k": "nyeGXUHngW64dyg2EuDs_8x6VGa14Bkrv1SFQwOzKfI"
+    }
+  ]
+}
+)";
+
+const char OldKid[] = "b3319a147514df7ee5e4bcdee51350cc890cc89e";
+const char NewKid[] = "62a93512c9ee4c7f8067b5a216dade2763d32a47";
+
+const std::chrono::seconds WaitTimeout(10);
+
+// Serves a JWKS to a provider and records its refreshes.
+class FakeIssuer {
+ public:
+  // Set the JWKS string served, or fail the fetches if ok is false.
+  void serve(const std::string& jwks, bool ok = true) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jwks_ = jwks;
+    ok_ = ok;
+  }
+
+  // Block the fetches until release() is called.
+  void block() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocked_ = true;
+  }
+
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      blocked_ = false;
+    }
+    cv_.notify_all();
+  }
+
+  size_t fetches() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fetches_;
+  }
+
+  // Wait until the given number of fetches have started.
+  bool waitForFetches(size_t fetches) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, WaitTimeout,
+                        [&] { return fetches_ >= fetches; });
+  }
+
+  // Wait until the given number of refreshes have completed.
+  bool waitForRefreshes(size_t refreshes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, WaitTimeout,
+                        [&] { return refreshes_ >= refreshes; });
+  }
+
+  // Wait until the last refresh has the given status.
+  bool waitForStatus(Status status) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, WaitTimeout, [&] {
+      return refreshes_ > 0 && last_status_ == status;
+    });
+  }
+
+  JwksProvider::Options options() {
+    JwksProvider::Options options;
+    options.refresh_interval = std::chrono::hours(1);
+    options.min_refresh_interval = std::chrono::milliseconds(10);
+    options.on_refresh = [this](Status status) {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++refreshes_;
+        last_status_ = status;
+      }
+      cv_.notify_all();
+    };
+    return options;
+  }
+
+  JwksProvider::Fetcher fetcher() {
+    return [this](std::string* jwks) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++fetches_;
+      cv_.notify_all();
+      cv_.wait(lock, [this] { return !blocked_; });
+      *jwks = jwks_;
+      return ok_;
+    };
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::string jwks_;
+  bool ok_ = true;
+  bool blocked_ = false;
+  size_t fetches_ = 0;
+  size_t refreshes_ = 0;
+  Status last_status_ = Status::Ok;
+};
+
+TEST(JwksProviderTest, FetchesKeysetOnStart) {
+  FakeIssuer issuer;
+  issuer.serve(SymmetricKeyHMAC);
+  JwksProvider provider(issuer.fetcher(), issuer.options());
+  ASSERT_TRUE(provider.waitForKeys(WaitTimeout));
+  JwksSnapshot jwks = provider.acquire();
+  ASSERT_NE(jwks, nullptr);
+  EXPECT_EQ(jwks->keys().size(), 1);
+  EXPECT_EQ(provider.lastStatus(), Status::Ok);
+}
+
+TEST(JwksProviderTest, RetriesFailedFirstFetch) {
+  FakeIssuer issuer;
+  issuer.serve("", false);
+  JwksProvider provider(issuer.fetcher(), issuer.options());
+  ASSERT_TRUE(issuer.waitForStatus(Status::JwksFetchError));
+  EXPECT_EQ(provider.lastStatus(), Status::JwksFetchError);
+  EXPECT_EQ(provider.acquire(), nullptr);
+
+  issuer.serve(SymmetricKeyHMAC);
+  EXPECT_TRUE(provider.waitForKeys(WaitTimeout));
+  EXPECT_NE(provider.acquire(), nullptr);
+}
+
+TEST(JwksProviderTest, KeepsLastGoodKeyset) {
+  FakeIssuer issuer;
+  issuer.serve(SymmetricKeyHMAC);
+  JwksProvider provider(issuer.fetcher(), issuer.options());
+  ASSERT_TRUE(issuer.waitForStatus(Status::Ok));
+  JwksSnapshot jwks = provider.acquire();
+  ASSERT_NE(jwks, nullptr);
+
+  issuer.serve("", false);
+  provider.requestRefresh();
+  ASSERT_TRUE(issuer.waitForStatus(Status::JwksFetchError));
+  EXPECT_EQ(provider.acquire(), jwks);
+
+  // Failed refreshes are retried without being requested.
+  issuer.serve(R"({"keys": []})");
+  ASSERT_TRUE(issuer.waitForStatus(Status::JwksNoValidKeys));
+  EXPECT_EQ(provider.acquire(), jwks);
+
+  issuer.serve(RotatedSymmetricKeyHMAC);
+  ASSERT_TRUE(issuer.waitForStatus(Status::Ok));
+  ASSERT_NE(provider.acquire(), jwks);
+  EXPECT_EQ(provider.acquire()->keys().size(), 2);
+}
+
+TEST(JwksProviderTest, UnknownKidRefreshesOnce) {
+  FakeIssuer issuer;
+  issuer.serve(SymmetricKeyHMAC);
+  JwksProvider provider(issuer.fetcher(), issuer.options());
+  ASSERT_TRUE(issuer.waitForStatus(Status::Ok));
+  JwksSnapshot jwks = provider.acquire();
+  EXPECT_EQ(provider.acquireForKid(OldKid), jwks);
+  EXPECT_EQ(provider.acquireForKid(""), jwks);
+
+  // A burst of tokens signed with a new key, before and while it's fetched.
+  issuer.block();
+  issuer.serve(RotatedSymmetricKeyHMAC);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < 4; ++i) {
+    workers.emplace_back([&] {
+      for (int j = 0; j < 100; ++j) {
+        EXPECT_NE(provider.acquireForKid(NewKid), nullptr);
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  ASSERT_TRUE(issuer.waitForFetches(2));
+  provider.acquireForKid(NewKid);
+  issuer.release();
+
+  ASSERT_TRUE(issuer.waitForRefreshes(2));
+  EXPECT_EQ(provider.lastStatus(), Status::Ok);
+  JwksSnapshot rotated = provider.acquireForKid(NewKid);
+  ASSERT_NE(rotated, jwks);
+  EXPECT_EQ(rotated->keys().size(), 2);
+
+  // Leave time for an extra refresh to start, if one was requested.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(issuer.fetches(), 2);
+}
+
+}  // namespace
+}  // namespace jwt_verify
+}  // namespace google
@@ -15,6 +15,7 @@
 #include "jwt_verify_lib/jwks.h"
 
 #include "gtest/gtest.h"
+#include "jwt_verify_lib/binary_utils.h"
 #include "test/test_common.h"
 
 namespace google {
@@ -104,6 +105,7 @@ TEST(JwksParseTest, GoodEC) {
   EXPECT_EQ(jwks->keys()[0]->kid_, "abc");
   EXPECT_EQ(jwks->keys()[0]->kty_, "EC");
   EXPECT_EQ(jwks->keys()[0]->crv_, "P-256");
+  EXPECT_EQ(jwks->keys()[0]->ec_signature_len_, 64);
 
   EXPECT_EQ(jwks->keys()[1]->alg_, "ES256");
   EXPECT_EQ(jwks->keys()[1]->kid_, "xyz");
@@ -114,11 +116,13 @@ TEST(JwksParseTest, GoodEC) {
   EXPECT_EQ(jwks->keys()[2]->kid_, "es384");
   EXPECT_EQ(jwks->keys()[2]->kty_, "EC");
   EXPECT_EQ(jwks->keys()[2]->crv_, "P-384");
+  EXPECT_EQ(jwks->keys()[2]->ec_signature_len_, 96);
 
   EXPECT_EQ(jwks->keys()[3]->alg_, "ES512");
   EXPECT_EQ(jwks->keys()[3]->kid_, "es512");
   EXPECT_EQ(jwks->keys()[3]->kty_, "EC");
   EXPECT_EQ(jwks->keys()[3]->crv_, "P-521");
+  EXPECT_EQ(jwks->keys()[3]->ec_signature_len_, 132);
 }
 
 TEST(JwksParseTest, GoodOKP) {
@@ -1323,6 +1327,510 @@ WwIDAQAB
   EXPECT_EQ(jwks->keys().at(1)->crv_, "");
 }
 
+TEST(JwksParseTest, KeysForKid) {
+  const std::string jwks_text = R"(
+     {
+        "keys": [
+            {"kty": "oct", "alg": "HS256", "kid": "a", "k": "a2V5MQ"},
+            {"kty": "oct", "alg": "HS256", "k": "a2V5Mg"},
+            {"kty": "oct", "alg": "HS256", "kid": "b", "k": "a2V5Mw"},
+            {"kty": "oct", "alg": "HS256", "kid": "a", "k": "a2V5NA"},
+            {"kty": "oct", "alg": "HS256", "k": "a2V5NQ"}
+        ]
+     }
+)";
+  auto jwks = Jwks::createFrom(jwks_text, Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  ASSERT_EQ(jwks->keys().size(), 5);
+
+  auto hmacKeys = [](const std::vector<const Jwks::Pubkey*>& keys) {
+    std::vector<std::string> hmac_keys;
+    for (const auto* key : keys) {
+      hmac_keys.push_back(key->hmac_key_);
+    }
+    return hmac_keys;
+  };
+  EXPECT_EQ(hmacKeys(jwks->keysForKid("")),
+            std::vector<std::string>({"key1", "key2", "key3", "key4", "key5"}));
+  EXPECT_EQ(hmacKeys(jwks->keysForKid("a")),
+            std::vector<std::string>({"key1", "key2", "key4", "key5"}));
+  EXPECT_EQ(hmacKeys(jwks->keysForKid("b")),
+            std::vector<std::string>({"key2", "key3", "key5"}));
+  EXPECT_EQ(hmacKeys(jwks->keysForKid("c")),
+            std::vector<std::string>({"key2", "key5"}));
+}
+
+TEST(JwksParseTest, KeysForKidFromPem) {
+  const std::string pem_text = R"(
+-----BEGIN PUBLIC KEY-----
+MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEYaOv1HVESfIWB6jnkijUTPKvwkFu
+CQnMe3gk4tp4DhYBSzTl6UXz9iRj15FMlmQpl9fV5nBfZMoUm47EkO7uaQ==
+-----END PUBLIC KEY-----
+)";
+  auto jwks = Jwks::createFromPem(pem_text, "kid1", "ES256");
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  ASSERT_EQ(jwks->keysForKid("kid1").size(), 1);
+  EXPECT_EQ(jwks->keysForKid("kid1")[0], jwks->keys()[0].get());
+  EXPECT_TRUE(jwks->keysForKid("kid2").empty());
+
+  EXPECT_EQ(jwks->addKeyFromPem(pem_text, "kid2", "ES256"), Status::Ok);
+  ASSERT_EQ(jwks->keysForKid("kid2").size(), 1);
+  EXPECT_EQ(jwks->keysForKid("kid2")[0], jwks->keys()[1].get());
+  EXPECT_EQ(jwks->keysForKid("").size(), 2);
+}
+
+TEST(JwksParseTest, PrecomputedKeyFields) {
+  const std::string jwks_text = R"(
+     {
+        "keys": [
+            {
+              "kty": "RSA",
+              "alg": "RS256",
+              "n": "0YWnm_eplO9BFtXszMRQNL5UtZ8HJdTH2jK7vjs4XdLkPW7YBkkm_2xNgcaVpkW0VT2l4mU3KftR-6s3Oa5Rnz5BrWEUkCTVVolR7VYksfqIB2I_x5yZHdOiomMTcm3DheUUCgbJRv5OKRnNqszA4xHn3tA3Ry8VO3X7BgKZYAUh9fyZTFLlkeAh0-bLK5zvqCmKW5QgDIXSxUTJxPjZCgfx1vmAfGqaJb-nvmrORXQ6L284c73DUL7mnt6wj3H6tVqPKA27j56N0TB1Hfx4ja6Slr8S4EB3F1luYhATa1PKUSH8mYDW11HolzZmTQpRoLV8ZoHbHEaTfqX_aYahIw",
+              "e": "AQAB"
+            },
+            {
+              "kty": "EC",
+              "crv": "P-256",
+              "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+              "y": "92bCBTvMFQ8lKbS2MbgjT3YfmYo6HnPEE2tsAqWUJw8"
+            },
+            {"kty": "oct", "alg": "HS384", "k": "a2V5MQ"},
+            {
+              "kty": "OKP",
+              "crv": "Ed25519",
+              "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+              "alg": "EdDSA"
+            },
+            {"kty": "oct", "k": "a2V5MQ"}
+        ]
+     }
+)";
+  auto jwks = Jwks::createFrom(jwks_text, Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  ASSERT_EQ(jwks->keys().size(), 5);
+
+  EXPECT_EQ(jwks->keys()[0]->key_type_, Jwks::KeyType::RSA);
+  EXPECT_EQ(jwks->keys()[0]->algorithm_, Jwks::Algorithm::RS256);
+  EXPECT_NE(jwks->keys()[0]->evp_pkey_, nullptr);
+  EXPECT_EQ(jwks->keys()[0]->ec_signature_len_, 0);
+
+  EXPECT_EQ(jwks->keys()[1]->key_type_, Jwks::KeyType::EC);
+  EXPECT_EQ(jwks->keys()[1]->algorithm_, Jwks::Algorithm::None);
+  EXPECT_NE(jwks->keys()[1]->evp_pkey_, nullptr);
+  EXPECT_EQ(jwks->keys()[1]->ec_signature_len_, 64);
+
+  EXPECT_EQ(jwks->keys()[2]->key_type_, Jwks::KeyType::Oct);
+  EXPECT_EQ(jwks->keys()[2]->algorithm_, Jwks::Algorithm::HS384);
+  EXPECT_EQ(jwks->keys()[2]->evp_pkey_, nullptr);
+  EXPECT_EQ(jwks->keys()[2]->hmac_sha256_, nullptr);
+  EXPECT_NE(jwks->keys()[2]->hmac_sha384_, nullptr);
+  EXPECT_EQ(jwks->keys()[2]->hmac_sha512_, nullptr);
+
+  EXPECT_EQ(jwks->keys()[3]->key_type_, Jwks::KeyType::OKP);
+  EXPECT_EQ(jwks->keys()[3]->algorithm_, Jwks::Algorithm::EdDSA);
+  EXPECT_EQ(jwks->keys()[3]->evp_pkey_, nullptr);
+
+  // An oct key without alg is keyed for all the digests.
+  EXPECT_EQ(jwks->keys()[4]->algorithm_, Jwks::Algorithm::None);
+  EXPECT_NE(jwks->keys()[4]->hmac_sha256_, nullptr);
+  EXPECT_NE(jwks->keys()[4]->hmac_sha384_, nullptr);
+  EXPECT_NE(jwks->keys()[4]->hmac_sha512_, nullptr);
+}
+
+TEST(JwksParseTest, PrecomputedKeyFieldsFromPem) {
+  const std::string pem_text = R"(
+-----BEGIN PUBLIC KEY-----
+MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEYaOv1HVESfIWB6jnkijUTPKvwkFu
+CQnMe3gk4tp4DhYBSzTl6UXz9iRj15FMlmQpl9fV5nBfZMoUm47EkO7uaQ==
+-----END PUBLIC KEY-----
+)";
+  auto jwks = Jwks::createFromPem(pem_text, "kid1", "ES256");
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  EXPECT_EQ(jwks->addKeyFromPem(pem_text, "kid2", "ES384"), Status::Ok);
+  EXPECT_EQ(jwks->addKeyFromPem(pem_text, "kid3", "EC256"), Status::Ok);
+  ASSERT_EQ(jwks->keys().size(), 3);
+
+  EXPECT_EQ(jwks->keys()[0]->key_type_, Jwks::KeyType::EC);
+  EXPECT_EQ(jwks->keys()[0]->algorithm_, Jwks::Algorithm::ES256);
+  EXPECT_NE(jwks->keys()[0]->evp_pkey_, nullptr);
+  EXPECT_EQ(jwks->keys()[1]->algorithm_, Jwks::Algorithm::ES384);
+  EXPECT_NE(jwks->keys()[1]->evp_pkey_, nullptr);
+  EXPECT_EQ(jwks->keys()[2]->algorithm_, Jwks::Algorithm::Unknown);
+}
+
+TEST(JwksParseTest, UpdateFromReusesUnchangedKeys) {
+  const std::string previous_text = R"(
+    {
+       "keys": [
+          {
+             "kty": "EC",
+             "crv": "P-256",
+             "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+             "y": "92bCBTvMFQ8lKbS2MbgjT3YfmYo6HnPEE2tsAqWUJw8",
+             "alg": "ES256",
+             "kid": "abc"
+          },
+          {
+             "kty": "EC",
+             "crv": "P-384",
+             "x": "yY8DWcyWlrr93FTrscI5Ydz2NC7emfoKYHJLX2dr3cSgfw0GuxAkuQ5nBMJmVV5g",
+             "y": "An5wVxEfksDOa_zvSHHGkeYJUfl8y11wYkOlFjBt9pOCw5-RlfZgPOa3pbmUquxZ",
+             "alg": "ES384",
+             "kid": "es384"
+          },
+          {"kty": "oct", "k": "a2V5MQ"}
+      ]
+     }
+)";
+  // The first and the oct keys are unchanged, the kid of the second key is
+  // rotated and a key is added.
+  const std::string jwks_text = R"(
+    {
+       "keys": [
+          {"kty": "oct", "k": "a2V5MQ"},
+          {
+             "kty": "EC",
+             "crv": "P-256",
+             "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+             "y": "92bCBTvMFQ8lKbS2MbgjT3YfmYo6HnPEE2tsAqWUJw8",
+             "alg": "ES256",
+             "kid": "abc"
+          },
+          {
+             "kty": "EC",
+             "crv": "P-384",
+             "x": "yY8DWcyWlrr93FTrscI5Ydz2NC7emfoKYHJLX2dr3cSgfw0GuxAkuQ5nBMJmVV5g",
+             "y": "An5wVxEfksDOa_zvSHHGkeYJUfl8y11wYkOlFjBt9pOCw5-RlfZgPOa3pbmUquxZ",
+             "alg": "ES384",
+             "kid": "es384-2"
+          },
+          {
+             "kty": "EC",
+             "crv": "P-521",
+             "x": "Abijiex7rz7t-_Zj_E6Oo0OXe9C_-MCSD-OWio15ATQGjH9WpbWjN62ZqrrU_nwJiqqwx6ZsYKhUc_J3PRaMbdVC",
+             "y": "FxaljCIuoVEA7PJIaDPJ5ePXtZ0hkinT1B_bQ91mShCiR_43Whsn1P7Gz30WEnLuJs1SGVz1oT4lIRUYni2OfIk",
+             "alg": "ES512",
+             "kid": "es512"
+          }
+      ]
+     }
+)";
+  auto previous = Jwks::createFrom(previous_text, Jwks::JWKS);
+  EXPECT_EQ(previous->getStatus(), Status::Ok);
+  auto jwks = Jwks::updateFrom(*previous, jwks_text);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  EXPECT_NE(jwks->generation(), previous->generation());
+  ASSERT_EQ(jwks->keys().size(), 4);
+
+  EXPECT_EQ(jwks->keys()[0]->kty_, "oct");
+  EXPECT_EQ(jwks->keys()[0]->hmac_key_, "key1");
+  EXPECT_NE(jwks->keys()[0]->hmac_sha256_, nullptr);
+  EXPECT_NE(jwks->keys()[0]->hmac_sha512_, nullptr);
+
+  EXPECT_EQ(jwks->keys()[1]->kid_, "abc");
+  EXPECT_EQ(jwks->keys()[1]->ec_key_.get(), previous->keys()[0]->ec_key_.get());
+  EXPECT_EQ(jwks->keys()[1]->evp_pkey_.get(),
+            previous->keys()[0]->evp_pkey_.get());
+  EXPECT_EQ(jwks->keys()[1]->algorithm_, Jwks::Algorithm::ES256);
+  EXPECT_EQ(jwks->keys()[1]->ec_signature_len_, 64);
+
+  EXPECT_EQ(jwks->keys()[2]->kid_, "es384-2");
+  EXPECT_NE(jwks->keys()[2]->ec_key_.get(), previous->keys()[1]->ec_key_.get());
+  EXPECT_EQ(jwks->keys()[3]->kid_, "es512");
+  EXPECT_NE(jwks->keys()[3]->ec_key_, nullptr);
+
+  EXPECT_EQ(jwks->keysForKid("abc").size(), 2);
+
+  // The shared keys outlive the previous keyset.
+  previous.reset();
+  EXPECT_EQ(jwks->keys()[1]->ec_signature_len_, 64);
+  EXPECT_EQ(EC_KEY_check_key(jwks->keys()[1]->ec_key_.get()), 1);
+}
+
+TEST(JwksParseTest, UpdateFromX509) {
+  auto previous = Jwks::createFrom(kPublicKeyX509, Jwks::JWKS);
+  EXPECT_EQ(previous->getStatus(), Status::Ok);
+  auto jwks = Jwks::updateFrom(*previous, kPublicKeyX509);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  ASSERT_EQ(jwks->keys().size(), 2);
+  for (const auto& key : jwks->keys()) {
+    // The order of the X509 keys is not specified.
+    const auto& previous_keys = previous->keysForKid(key->kid_);
+    ASSERT_EQ(previous_keys.size(), 1);
+    EXPECT_EQ(key->rsa_.get(), previous_keys[0]->rsa_.get());
+    EXPECT_EQ(key->x509_.get(), previous_keys[0]->x509_.get());
+  }
+}
+
+TEST(JwksParseTest, UpdateFromSameStatusAsCreateFrom) {
+  auto previous = Jwks::createFrom(kPublicKeyX509, Jwks::JWKS);
+  for (const std::string& jwks_text :
+       {std::string("foobar"), std::string(R"({"keys": 1})"),
+        std::string(R"({"keys": [{"kty": "oct"}]})"),
+        std::string(R"({"keys": [{"kty": "oct", "k": "a2V5MQ"}, {}]})")}) {
+    auto jwks = Jwks::updateFrom(*previous, jwks_text);
+    EXPECT_EQ(jwks->getStatus(),
+              Jwks::createFrom(jwks_text, Jwks::JWKS)->getStatus());
+  }
+}
+
+// Expects the keys of jwks and other to have the same fields.
+void expectSameKeys(const Jwks& jwks, const Jwks& other) {
+  ASSERT_EQ(jwks.keys().size(), other.keys().size());
+  for (size_t i = 0; i < jwks.keys().size(); ++i) {
+    const Jwks::Pubkey& key = *jwks.keys()[i];
+    const Jwks::Pubkey& other_key = *other.keys()[i];
+    EXPECT_EQ(key.kid_, other_key.kid_);
+    EXPECT_EQ(key.kty_, other_key.kty_);
+    EXPECT_EQ(key.alg_, other_key.alg_);
+    EXPECT_EQ(key.crv_, other_key.crv_);
+    EXPECT_EQ(key.hmac_key_, other_key.hmac_key_);
+    EXPECT_EQ(key.okp_key_raw_, other_key.okp_key_raw_);
+    EXPECT_EQ(key.fingerprint_, other_key.fingerprint_);
+    EXPECT_EQ(key.key_type_, other_key.key_type_);
+    EXPECT_EQ(key.algorithm_, other_key.algorithm_);
+    EXPECT_EQ(key.ec_signature_len_, other_key.ec_signature_len_);
+    EXPECT_EQ(key.evp_pkey_ == nullptr, other_key.evp_pkey_ == nullptr);
+    EXPECT_EQ(key.hmac_sha256_ == nullptr, other_key.hmac_sha256_ == nullptr);
+    EXPECT_EQ(key.hmac_sha384_ == nullptr, other_key.hmac_sha384_ == nullptr);
+    EXPECT_EQ(key.hmac_sha512_ == nullptr, other_key.hmac_sha512_ == nullptr);
+    if (key.evp_pkey_ != nullptr && other_key.evp_pkey_ != nullptr) {
+      EXPECT_EQ(EVP_PKEY_cmp(key.evp_pkey_.get(), other_key.evp_pkey_.get()),
+                1);
+    }
+  }
+}
+
+TEST(JwksParseTest, BinaryRoundTrip) {
+  const std::string jwks_text = R"(
+     {
+        "keys": [
+            {
+              "kty": "RSA",
+              "alg": "RS256",
+              "n": "0YWnm_eplO9BFtXszMRQNL5UtZ8HJdTH2jK7vjs4XdLkPW7YBkkm_2xNgcaVpkW0VT2l4mU3KftR-6s3Oa5Rnz5BrWEUkCTVVolR7VYksfqIB2I_x5yZHdOiomMTcm3DheUUCgbJRv5OKRnNqszA4xHn3tA3Ry8VO3X7BgKZYAUh9fyZTFLlkeAh0-bLK5zvqCmKW5QgDIXSxUTJxPjZCgfx1vmAfGqaJb-nvmrORXQ6L284c73DUL7mnt6wj3H6tVqPKA27j56N0TB1Hfx4ja6Slr8S4EB3F1luYhATa1PKUSH8mYDW11HolzZmTQpRoLV8ZoHbHEaTfqX_aYahIw",
+              "e": "AQAB"
+            },
+            {
+              "kty": "EC",
+              "crv": "P-256",
+              "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+              "y": "92bCBTvMFQ8lKbS2MbgjT3YfmYo6HnPEE2tsAqWUJw8"
+            },
+            {"kty": "oct", "alg": "HS384", "k": "a2V5MQ"},
+            {
+              "kty": "OKP",
+              "crv": "Ed25519",
+              "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+              "alg": "EdDSA"
+            },
+            {"kty": "oct", "k": "a2V5MQ"}
+        ]
+     }
+)";
+  auto jwks = Jwks::createFrom(jwks_text, Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+
+  auto loaded = Jwks::createFromBinary(jwks->serializeBinary());
+  EXPECT_EQ(loaded->getStatus(), Status::Ok);
+  expectSameKeys(*loaded, *jwks);
+  EXPECT_EQ(loaded->serializeBinary(), jwks->serializeBinary());
+}
+
+TEST(JwksParseTest, BinaryRoundTripX509AndPem) {
+  auto jwks = Jwks::createFrom(kPublicKeyX509, Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  auto loaded = Jwks::createFromBinary(jwks->serializeBinary());
+  EXPECT_EQ(loaded->getStatus(), Status::Ok);
+  expectSameKeys(*loaded, *jwks);
+
+  const std::string pem_text = R"(
+-----BEGIN PUBLIC KEY-----
+MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEYaOv1HVESfIWB6jnkijUTPKvwkFu
+CQnMe3gk4tp4DhYBSzTl6UXz9iRj15FMlmQpl9fV5nBfZMoUm47EkO7uaQ==
+-----END PUBLIC KEY-----
+)";
+  jwks = Jwks::createFromPem(pem_text, "kid1", "ES256");
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  loaded = Jwks::createFromBinary(jwks->serializeBinary());
+  EXPECT_EQ(loaded->getStatus(), Status::Ok);
+  expectSameKeys(*loaded, *jwks);
+}
+
+TEST(JwksParseTest, BinaryErrors) {
+  const std::string jwks_text = R"({"keys": [{"kty": "oct", "k": "a2V5MQ"}]})";
+  const std::string binary =
+      Jwks::createFrom(jwks_text, Jwks::JWKS)->serializeBinary();
+
+  EXPECT_EQ(Jwks::createFromBinary("")->getStatus(),
+            Status::JwksBinaryParseError);
+  EXPECT_EQ(Jwks::createFromBinary(jwks_text)->getStatus(),
+            Status::JwksBinaryParseError);
+  // Each truncation fails.
+  for (size_t length = 0; length < binary.length(); ++length) {
+    auto jwks = Jwks::createFromBinary(binary.substr(0, length));
+    EXPECT_EQ(jwks->getStatus(), Status::JwksBinaryParseError) << length;
+    EXPECT_TRUE(jwks->keys().empty());
+  }
+  EXPECT_EQ(Jwks::createFromBinary(binary + "x")->getStatus(),
+            Status::JwksBinaryParseError);
+
+  std::string bad_version = binary;
+  bad_version[4] = 2;
+  EXPECT_EQ(Jwks::createFromBinary(bad_version)->getStatus(),
+            Status::JwksBinaryBadVersion);
+
+  // A key count of 0.
+  EXPECT_EQ(Jwks::createFromBinary(binary.substr(0, 8) + std::string(4, '\0'))
+                ->getStatus(),
+            Status::JwksNoValidKeys);
+
+  // An oct key material with an RSA kty.
+  std::string bad_kty = binary;
+  const size_t kty_pos = bad_kty.find("oct");
+  ASSERT_NE(kty_pos, std::string::npos);
+  bad_kty.replace(kty_pos, 3, "RSA");
+  auto jwks = Jwks::createFromBinary(bad_kty);
+  EXPECT_EQ(jwks->getStatus(), Status::JwksBinaryParseError);
+  EXPECT_TRUE(jwks->keys().empty());
+
+  // An unknown key kind, after the magic, the version and the key count.
+  std::string bad_kind = binary;
+  bad_kind[12] = 9;
+  EXPECT_EQ(Jwks::createFromBinary(bad_kind)->getStatus(),
+            Status::JwksBinaryParseError);
+}
+
+// Replaces the first string field from in a binary keyset with to.
+std::string replaceBinaryField(const std::string& binary,
+                               absl::string_view from, absl::string_view to) {
+  std::string from_field;
+  appendBytes(from, &from_field);
+  std::string to_field;
+  appendBytes(to, &to_field);
+  std::string replaced = binary;
+  const size_t pos = replaced.find(from_field);
+  EXPECT_NE(pos, std::string::npos) << from;
+  if (pos != std::string::npos) {
+    replaced.replace(pos, from_field.length(), to_field);
+  }
+  return replaced;
+}
+
+TEST(JwksParseTest, BinaryAlgErrors) {
+  const std::string rsa_text = R"(
+     {
+        "keys": [{
+          "kty": "RSA",
+          "alg": "RS256",
+          "n": "0YWnm_eplO9BFtXszMRQNL5UtZ8HJdTH2jK7vjs4XdLkPW7YBkkm_2xNgcaVpkW0VT2l4mU3KftR-6s3Oa5Rnz5BrWEUkCTVVolR7VYksfqIB2I_x5yZHdOiomMTcm3DheUUCgbJRv5OKRnNqszA4xHn3tA3Ry8VO3X7BgKZYAUh9fyZTFLlkeAh0-bLK5zvqCmKW5QgDIXSxUTJxPjZCgfx1vmAfGqaJb-nvmrORXQ6L284c73DUL7mnt6wj3H6tVqPKA27j56N0TB1Hfx4ja6Slr8S4EB3F1luYhATa1PKUSH8mYDW11HolzZmTQpRoLV8ZoHbHEaTfqX_aYahIw",
+          "e": "AQAB"
+        }]
+     }
+)";
+  const std::string ec_text = R"(
+     {
+        "keys": [{
+          "kty": "EC",
+          "alg": "ES256",
+          "crv": "P-256",
+          "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k",
+          "y": "92bCBTvMFQ8lKbS2MbgjT3YfmYo6HnPEE2tsAqWUJw8"
+        }]
+     }
+)";
+  const std::string oct_text =
+      R"({"keys": [{"kty": "oct", "alg": "HS256", "k": "a2V5MQ"}]})";
+  const std::string okp_text = R"(
+     {
+        "keys": [{
+          "kty": "OKP",
+          "alg": "EdDSA",
+          "crv": "Ed25519",
+          "x": "EB54wykhS7YJFD6RYJNnwbWEz3cI7CF5bCDTXlrwI5k"
+        }]
+     }
+)";
+  // The binary keysets get the checks of the alg and crv of the JWKs.
+  struct {
+    const std::string& jwks_text;
+    const char* from;
+    const char* to;
+    Status status;
+  } cases[] = {
+      {rsa_text, "RS256", "HS256", Status::JwksRSAKeyBadAlg},
+      {ec_text, "ES256", "HS256", Status::JwksECKeyBadAlg},
+      {ec_text, "ES256", "ES512", Status::JwksECKeyAlgNotCompatibleWithCrv},
+      // The crv doesn't match the curve of the key.
+      {ec_text, "P-256", "P-384", Status::JwksECKeyAlgNotCompatibleWithCrv},
+      {oct_text, "HS256", "RS256", Status::JwksHMACKeyBadAlg},
+      {okp_text, "EdDSA", "ES256", Status::JwksOKPKeyBadAlg},
+      {okp_text, "Ed25519", "X25519", Status::JwksOKPKeyCrvUnsupported},
+  };
+  for (const auto& c : cases) {
+    auto jwks = Jwks::createFrom(c.jwks_text, Jwks::JWKS);
+    ASSERT_EQ(jwks->getStatus(), Status::Ok);
+    const std::string binary = jwks->serializeBinary();
+    EXPECT_EQ(Jwks::createFromBinary(binary)->getStatus(), Status::Ok);
+
+    auto loaded =
+        Jwks::createFromBinary(replaceBinaryField(binary, c.from, c.to));
+    EXPECT_EQ(loaded->getStatus(), c.status) << c.from << " " << c.to;
+    EXPECT_TRUE(loaded->keys().empty());
+  }
+}
+
+TEST(JwksParseTest, ParseErrorAfterValidKeys) {
+  // The keys are extracted while the document is read, an error after them
+  // still fails the whole keyset.
+  const std::string jwks_text = R"(
+     {
+        "keys": [{"kty": "oct", "k": "a2V5MQ"}],
+        "keys": []
+     }
+)";
+  auto jwks = Jwks::createFrom(jwks_text, Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::JwksParseError);
+  EXPECT_TRUE(jwks->keys().empty());
+
+  jwks = Jwks::createFrom(R"({"keys": [{"kty": "oct", "k": "a2V5MQ"}]} x)",
+                          Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::JwksParseError);
+  EXPECT_TRUE(jwks->keys().empty());
+}
+
+TEST(JwksParseTest, KeysWithOtherFields) {
+  const std::string jwks_text = R"(
+     {
+        "kid1": "-----BEGIN CERTIFICATE-----\nfoo\n-----END CERTIFICATE-----\n",
+        "keys": [
+            1,
+            ["a", {"kty": "RSA"}],
+            {
+              "kty": "oct",
+              "x5c": ["a", {"b": null}],
+              "k": "a2V5MQ",
+              "kid": 1,
+              "use": {"nested": {"kty": "RSA"}}
+            },
+            {"kty": "oct", "k": null}
+        ],
+        "other": {"keys": 1}
+     }
+)";
+  auto jwks = Jwks::createFrom(jwks_text, Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  ASSERT_EQ(jwks->keys().size(), 1);
+  EXPECT_EQ(jwks->keys()[0]->kty_, "oct");
+  EXPECT_EQ(jwks->keys()[0]->kid_, "");
+  EXPECT_EQ(jwks->keys()[0]->hmac_key_, "key1");
+
+  jwks = Jwks::createFrom(R"({"keys": [{"kty": "oct", "k": null}]})",
+                          Jwks::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::JwksHMACKeyBadK);
+}
+
 TEST(JwksParseTest, addKeyFromPemError) {
   const std::string good_pem_text = R"(
 -----BEGIN PUBLIC KEY-----
@@ -1345,6 +1853,31 @@ bad-pub-key
   EXPECT_EQ(jwks->keys().size(), 1);
 }
 
+TEST(JwksParseTest, KeyHint) {
+  const std::string pem_text = R"(
+-----BEGIN PUBLIC KEY-----
+MFkwEwYHKoZIzj0CAQYIKoZIzj0DAQcDQgAEYaOv1HVESfIWB6jnkijUTPKvwkFu
+CQnMe3gk4tp4DhYBSzTl6UXz9iRj15FMlmQpl9fV5nBfZMoUm47EkO7uaQ==
+-----END PUBLIC KEY-----
+)";
+  auto jwks = Jwks::createFromPem(pem_text, "", "ES256");
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  EXPECT_EQ(jwks->keyHint("iss", "", "ES256"), Jwks::kNoKeyHint);
+
+  jwks->setKeyHint("iss", "", "ES256", 3);
+  EXPECT_EQ(jwks->keyHint("iss", "", "ES256"), 3);
+  EXPECT_EQ(jwks->keyHint("other_iss", "", "ES256"), Jwks::kNoKeyHint);
+  EXPECT_EQ(jwks->keyHint("iss", "kid", "ES256"), Jwks::kNoKeyHint);
+  EXPECT_EQ(jwks->keyHint("iss", "", "ES384"), Jwks::kNoKeyHint);
+
+  jwks->setKeyHint("iss", "", "ES256", 0);
+  EXPECT_EQ(jwks->keyHint("iss", "", "ES256"), 0);
+
+  // Adding a key clears the hints.
+  EXPECT_EQ(jwks->addKeyFromPem(pem_text, "", "ES256"), Status::Ok);
+  EXPECT_EQ(jwks->keyHint("iss", "", "ES256"), Jwks::kNoKeyHint);
+}
+
 }  // namespace
 }  // namespace jwt_verify
 }  // namespace google
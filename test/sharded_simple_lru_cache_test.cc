@@ -0,0 +1,171 @@
+/* Copyright 2016 Google Inc. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+
+//
+// Tests for ShardedSimpleLRUCache
+
+#include "simple_lru_cache/sharded_simple_lru_cache.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace google {
+namespace simple_lru_cache {
+namespace {
+
+typedef ShardedSimpleLRUCache<int, std::string> TestCache;
+
+TEST(ShardedSimpleLRUCacheTest, InsertLookupRelease) {
+  TestCache cache(4, 100);
+  EXPECT_EQ(cache.numShards(), 4);
+  for (int i = 0; i < 10; ++i) {
+    cache.insert(i, new std::string(std::to_string(i)), 1);
+  }
+  EXPECT_EQ(cache.entries(), 10);
+  EXPECT_EQ(cache.size(), 10);
+
+  for (int i = 0; i < 10; ++i) {
+    std::string* value = cache.lookup(i);
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, std::to_string(i));
+    cache.release(i, value);
+  }
+  EXPECT_EQ(cache.lookup(10), nullptr);
+
+  cache.remove(3);
+  EXPECT_EQ(cache.lookup(3), nullptr);
+  EXPECT_EQ(cache.entries(), 9);
+
+  cache.removeAll();
+  EXPECT_EQ(cache.entries(), 0);
+}
+
+TEST(ShardedSimpleLRUCacheTest, ScopedLookup) {
+  TestCache cache(2, 10);
+  cache.insert(1, new std::string("one"), 1);
+  {
+    TestCache::ScopedLookup lookup(&cache, 1);
+    ASSERT_TRUE(lookup.found());
+    EXPECT_EQ(*lookup.value(), "one");
+    // A pinned entry is kept until it is released.
+    cache.remove(1);
+    EXPECT_EQ(*lookup.value(), "one");
+  }
+  TestCache::ScopedLookup lookup(&cache, 1);
+  EXPECT_FALSE(lookup.found());
+}
+
+TEST(ShardedSimpleLRUCacheTest, BudgetSplitAcrossShards) {
+  TestCache cache(3, 10);
+  EXPECT_EQ(cache.maxSize(), 10);
+  cache.setMaxSize(20);
+  EXPECT_EQ(cache.maxSize(), 20);
+
+  // No shard holds more than its part of the budget.
+  cache.setMaxSize(3);
+  for (int i = 0; i < 100; ++i) {
+    cache.insert(i, new std::string(std::to_string(i)), 1);
+  }
+  EXPECT_LE(cache.size(), 3);
+  EXPECT_EQ(cache.entries(), cache.size());
+
+  // The most recent key of each shard is kept.
+  std::string* value = cache.lookup(99);
+  ASSERT_NE(value, nullptr);
+  cache.release(99, value);
+}
+
+TEST(ShardedSimpleLRUCacheTest, InsertAndSweep) {
+  TestCache cache(1, 100);
+  auto expired = [](const std::string& value) { return value == "expired"; };
+  cache.insert(1, new std::string("expired"), 1);
+  cache.insert(2, new std::string("two"), 1);
+
+  cache.insertAndSweep(3, new std::string("expired"), 1, 1, expired);
+  EXPECT_EQ(cache.lookup(1), nullptr);
+  EXPECT_EQ(cache.entries(), 2);
+
+  // The shard was already swept in this epoch.
+  cache.insertAndSweep(4, new std::string("four"), 1, 1, expired);
+  EXPECT_EQ(cache.entries(), 3);
+  cache.insertAndSweep(5, new std::string("five"), 1, 2, expired);
+  EXPECT_EQ(cache.entries(), 3);
+  EXPECT_EQ(cache.lookup(3), nullptr);
+}
+
+TEST(ShardedSimpleLRUCacheTest, RemoveIf) {
+  TestCache cache(4, 100);
+  for (int i = 0; i < 10; ++i) {
+    cache.insert(i, new std::string(std::to_string(i % 2)), 1);
+  }
+  {
+    TestCache::ScopedLookup lookup(&cache, 1);
+    cache.removeIf([](const std::string& value) { return value == "1"; });
+    EXPECT_EQ(cache.entries(), 5);
+    // A pinned entry is kept until it is released.
+    EXPECT_EQ(*lookup.value(), "1");
+  }
+  TestCache::ScopedLookup lookup(&cache, 1);
+  EXPECT_FALSE(lookup.found());
+}
+
+TEST(ShardedSimpleLRUCacheTest, ZeroShards) {
+  TestCache cache(0, 10);
+  EXPECT_EQ(cache.numShards(), 1);
+  cache.insert(1, new std::string("one"), 1);
+  EXPECT_EQ(cache.entries(), 1);
+}
+
+TEST(ShardedSimpleLRUCacheTest, KeysSpreadAcrossShards) {
+  TestCache cache(8, 1000);
+  std::vector<int> counts(cache.numShards());
+  for (int i = 0; i < 800; ++i) {
+    ++counts[cache.shardIndex(i)];
+  }
+  for (int count : counts) {
+    EXPECT_GT(count, 50);
+  }
+}
+
+TEST(ShardedSimpleLRUCacheTest, ConcurrentAccess) {
+  TestCache cache(8, 500);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 1000; ++i) {
+        const int key = (t * 1000 + i) % 700;
+        std::string* value = cache.lookup(key);
+        if (value == nullptr) {
+          cache.insert(key, new std::string(std::to_string(key)), 1);
+        } else {
+          EXPECT_EQ(*value, std::to_string(key));
+          cache.release(key, value);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(cache.size(), 500);
+}
+
+}  // namespace
+}  // namespace simple_lru_cache
+}  // namespace google
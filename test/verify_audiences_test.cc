@@ -96,6 +96,21 @@ TEST(VerifyAudTest, Success) {
   EXPECT_EQ(verifyJwt(jwt, *jwks, std::vector<std::string>{}), Status::Ok);
 }
 
+TEST(VerifyAudTest, PrebuiltCheckAudience) {
+  Jwt jwt;
+  auto jwks = Jwks::createFrom(PublicKeyRSA, Jwks::Type::JWKS);
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  EXPECT_EQ(jwt.parseFromString(JwtOneAudtext), Status::Ok);
+
+  const CheckAudience allowed({"https://aud1/", "aud3"});
+  const CheckAudience not_allowed({"aud2", "aud3"});
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_EQ(verifyJwt(jwt, *jwks, allowed), Status::Ok);
+    EXPECT_EQ(verifyJwt(jwt, *jwks, not_allowed),
+              Status::JwtAudienceNotAllowed);
+  }
+}
+
 }  // namespace
 }  // namespace jwt_verify
 }  // namespace google
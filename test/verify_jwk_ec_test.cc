@@ -227,6 +227,50 @@ TEST_F(VerifyJwkECTest, NoKidOK) {
   });
 }
 
+TEST_F(VerifyJwkECTest, ReuseVerifyContextOK) {
+  VerifyContext context;
+  for (const std::string& jwt_text : {JwtTextEC, JwtES384Text, JwtES512Text}) {
+    JwtView jwt;
+    EXPECT_EQ(jwt.parseFromString(jwt_text), Status::Ok);
+    EXPECT_EQ(verifyJwt(jwt, *jwks_, 1, kClockSkewInSecond, context),
+              Status::Ok);
+    EXPECT_EQ(verifyJwtWithoutTimeChecking(jwt, *jwks_, context), Status::Ok);
+  }
+}
+
+TEST_F(VerifyJwkECTest, BinaryKeysetOK) {
+  auto jwks = Jwks::createFromBinary(jwks_->serializeBinary());
+  EXPECT_EQ(jwks->getStatus(), Status::Ok);
+  for (const std::string& jwt_text : {JwtTextEC, JwtES384Text, JwtES512Text}) {
+    Jwt jwt;
+    EXPECT_EQ(jwt.parseFromString(jwt_text), Status::Ok);
+    EXPECT_EQ(verifyJwt(jwt, *jwks), Status::Ok);
+  }
+}
+
+TEST_F(VerifyJwkECTest, FixedAlgVerifierOK) {
+  const Verifier<Jwks::Algorithm::ES256> es256;
+  const Verifier<Jwks::Algorithm::ES384> es384;
+  const Verifier<Jwks::Algorithm::ES512> es512;
+  JwtView view;
+  EXPECT_EQ(es256.verify(JwtTextEC, *jwks_, 1, &view), Status::Ok);
+  EXPECT_EQ(es384.verify(JwtES384Text, *jwks_, 1, &view), Status::Ok);
+  EXPECT_EQ(es512.verify(JwtES512Text, *jwks_, 1, &view), Status::Ok);
+  // A token of another alg is rejected as verifyJwt does.
+  EXPECT_EQ(es384.verify(JwtTextEC, *jwks_, 1, &view),
+            Status::JwksKidAlgMismatch);
+
+  Jwt jwt;
+  EXPECT_EQ(jwt.parseFromString(JwtES512Text), Status::Ok);
+  EXPECT_EQ(es512.verifyWithoutTimeChecking(jwt, *jwks_), Status::Ok);
+  EXPECT_EQ(es256.verifyWithoutTimeChecking(jwt, *jwks_),
+            Status::JwksKidAlgMismatch);
+  fuzzJwtSignature(jwt, [this, &es512](const Jwt& jwt) {
+    EXPECT_EQ(es512.verifyWithoutTimeChecking(jwt, *jwks_),
+              Status::JwtVerificationFail);
+  });
+}
+
 TEST_F(VerifyJwkECTest, NonExistKidFail) {
   Jwt jwt;
   EXPECT_EQ(jwt.parseFromString(JwtTextWithNonExistKidEC), Status::Ok);
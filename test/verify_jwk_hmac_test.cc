@@ -12,6 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+
 #include "gtest/gtest.h"
 #include "jwt_verify_lib/verify.h"
 #include "test/test_common.h"
@@ -194,6 +200,24 @@ TEST_F(VerifyJwkHmacTest, CorrectKidHS512OK) {
   });
 }
 
+TEST_F(VerifyJwkHmacTest, FixedAlgVerifierOK) {
+  const Verifier<Jwks::Algorithm::HS256> hs256;
+  const Verifier<Jwks::Algorithm::HS384> hs384;
+  JwtView view;
+  EXPECT_EQ(hs256.verify(JwtTextNoKid, *jwks_, 1, &view), Status::Ok);
+  EXPECT_EQ(hs384.verify(JwtHS384TextWithCorrectKid, *jwks_, 1, &view),
+            Status::Ok);
+  EXPECT_EQ(hs384.verify(JwtTextNoKid, *jwks_, 1, &view),
+            Status::JwksKidAlgMismatch);
+
+  Jwt jwt;
+  EXPECT_EQ(jwt.parseFromString(JwtTextNoKid), Status::Ok);
+  fuzzJwtSignature(jwt, [this, &hs256](const Jwt& jwt) {
+    EXPECT_EQ(hs256.verifyWithoutTimeChecking(jwt, *jwks_),
+              Status::JwtVerificationFail);
+  });
+}
+
 TEST_F(VerifyJwkHmacTest, NonExistKidFail) {
   Jwt jwt;
   EXPECT_EQ(jwt.parseFromString(JwtTextWithNonExistKid), Status::Ok);
@@ -237,6 +261,227 @@ TEST_F(VerifyJwkHmacTest, OkSymmetricKeyNotKid) {
   EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::Ok);
 }
 
+TEST_F(VerifyJwkHmacTest, NoKidSetsKeyHint) {
+  Jwt jwt;
+  EXPECT_EQ(jwt.parseFromString(JwtTextNoKidLongExp), Status::Ok);
+  EXPECT_EQ(jwks_->keyHint(jwt.iss_, "", "HS256"), Jwks::kNoKeyHint);
+  EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::Ok);
+  // The second key of the keyset.
+  EXPECT_EQ(jwks_->keyHint(jwt.iss_, "", "HS256"), 1);
+  EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::Ok);
+
+  // A wrong hint is only a slower verification.
+  jwks_->setKeyHint(jwt.iss_, "", "HS256", 0);
+  EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::Ok);
+  EXPECT_EQ(jwks_->keyHint(jwt.iss_, "", "HS256"), 1);
+  jwks_->setKeyHint(jwt.iss_, "", "HS256", 100);
+  EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::Ok);
+
+  std::string tampered = JwtTextNoKidLongExp;
+  tampered[tampered.size() - 5] ^= 1;
+  EXPECT_EQ(jwt.parseFromString(tampered), Status::Ok);
+  EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::JwtVerificationFail);
+  EXPECT_EQ(jwks_->keyHint(jwt.iss_, "", "HS256"), 1);
+}
+
+// Verifies the tokens one by one and as a batch, at the given time.
+void expectBatchSameAsVerifyJwt(const std::vector<std::string>& jwt_texts,
+                                const Jwks& jwks, uint64_t now,
+                                const Executor& executor) {
+  std::vector<Jwt> jwts(jwt_texts.size());
+  std::vector<const Jwt*> jwt_ptrs;
+  std::vector<Status> expected;
+  for (size_t i = 0; i < jwt_texts.size(); ++i) {
+    EXPECT_EQ(jwts[i].parseFromString(jwt_texts[i]), Status::Ok);
+    jwt_ptrs.push_back(&jwts[i]);
+    expected.push_back(verifyJwt(jwts[i], jwks, now));
+  }
+
+  std::vector<Status> out(jwt_ptrs.size(), Status::Ok);
+  verifyJwtBatch(jwt_ptrs, jwks, now, absl::MakeSpan(out), executor);
+  EXPECT_EQ(out, expected);
+}
+
+class VerifyJwkHmacBatchTest : public VerifyJwkHmacTest {
+ protected:
+  void SetUp() {
+    VerifyJwkHmacTest::SetUp();
+    // More tokens of one kid than verified by a single task.
+    // Tokens with a bad signature in between good tokens of the same key.
+    std::string tampered = JwtHS256TextWithCorrectKid;
+    tampered[tampered.size() - 5] ^= 1;
+    for (int i = 0; i < 40; ++i) {
+      jwt_texts_.push_back(JwtHS256TextWithCorrectKid);
+      jwt_texts_.push_back(JwtTextNoKidLongExp);
+      if (i % 7 == 0) {
+        jwt_texts_.push_back(tampered);
+      }
+    }
+    jwt_texts_.push_back(JwtTextNoKid);
+    jwt_texts_.push_back(JwtHS384TextWithCorrectKid);
+    jwt_texts_.push_back(JwtHS512TextWithCorrectKid);
+    jwt_texts_.push_back(JwtTextWithIncorrectKid);
+    jwt_texts_.push_back(JwtTextWithNonExistKid);
+  }
+
+  std::vector<std::string> jwt_texts_;
+};
+
+TEST_F(VerifyJwkHmacBatchTest, SameAsVerifyJwt) {
+  expectBatchSameAsVerifyJwt(jwt_texts_, *jwks_, 1, nullptr);
+  // All the tokens but the one with a long exp are expired.
+  expectBatchSameAsVerifyJwt(jwt_texts_, *jwks_, 1600000000, nullptr);
+  expectBatchSameAsVerifyJwt({}, *jwks_, 1, nullptr);
+}
+
+TEST_F(VerifyJwkHmacBatchTest, SameAsVerifyJwtWithExecutor) {
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  Executor executor = [&threads, &mutex](std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.emplace_back(std::move(task));
+  };
+  expectBatchSameAsVerifyJwt(jwt_texts_, *jwks_, 1, executor);
+  expectBatchSameAsVerifyJwt(jwt_texts_, *jwks_, 1600000000, executor);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // An executor running the tasks inline.
+  expectBatchSameAsVerifyJwt(
+      jwt_texts_, *jwks_, 1,
+      [](std::function<void()> task) { task(); });
+}
+
+TEST_F(VerifyJwkHmacBatchTest, SameAsVerifyJwtOnThreadOfExecutor) {
+  // A pool of one thread, the batch is verified from the thread.
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> queue;
+  bool stopped = false;
+  std::thread worker([&]() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      cv.wait(lock, [&]() { return stopped || !queue.empty(); });
+      if (queue.empty()) {
+        return;
+      }
+      std::function<void()> task = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  });
+  Executor executor = [&](std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(std::move(task));
+    cv.notify_one();
+  };
+
+  std::promise<void> verified;
+  executor([&]() {
+    expectBatchSameAsVerifyJwt(jwt_texts_, *jwks_, 1, executor);
+    verified.set_value();
+  });
+  verified.get_future().wait();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopped = true;
+    cv.notify_one();
+  }
+  worker.join();
+
+  // An executor dropping the tasks.
+  expectBatchSameAsVerifyJwt(jwt_texts_, *jwks_, 1,
+                             [](std::function<void()>) {});
+}
+
+// Verifies the tokens with verifier and with verifyJwt, at the given time.
+void expectParallelSameAsVerifyJwt(const std::vector<std::string>& jwt_texts,
+                                   const Jwks& jwks, uint64_t now,
+                                   ParallelVerifier& verifier) {
+  for (const std::string& jwt_text : jwt_texts) {
+    Jwt jwt;
+    EXPECT_EQ(jwt.parseFromString(jwt_text), Status::Ok);
+    EXPECT_EQ(verifier.verify(jwt, jwks, now), verifyJwt(jwt, jwks, now));
+  }
+}
+
+TEST_F(VerifyJwkHmacBatchTest, ParallelSameAsVerifyJwt) {
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  Executor executor = [&threads, &mutex](std::function<void()> task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threads.emplace_back(std::move(task));
+  };
+  // All the candidate keys are verified in parallel.
+  ParallelVerifier verifier(executor, 1);
+  expectParallelSameAsVerifyJwt(jwt_texts_, *jwks_, 1, verifier);
+  expectParallelSameAsVerifyJwt(jwt_texts_, *jwks_, 1600000000, verifier);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  ParallelVerifier inline_verifier(
+      [](std::function<void()> task) { task(); }, 1);
+  expectParallelSameAsVerifyJwt(jwt_texts_, *jwks_, 1, inline_verifier);
+
+  ParallelVerifier sequential_verifier(nullptr);
+  expectParallelSameAsVerifyJwt(jwt_texts_, *jwks_, 1, sequential_verifier);
+}
+
+TEST_F(VerifyJwkHmacBatchTest, ParallelTriesKeyHintFirst) {
+  size_t tasks = 0;
+  ParallelVerifier verifier(
+      [&tasks](std::function<void()> task) {
+        ++tasks;
+        task();
+      },
+      1);
+
+  Jwt jwt;
+  EXPECT_EQ(jwt.parseFromString(JwtTextNoKidLongExp), Status::Ok);
+  EXPECT_EQ(verifier.verifyWithoutTimeChecking(jwt, *jwks_), Status::Ok);
+  // One of the HS256 keys is tried on the calling thread.
+  EXPECT_EQ(tasks, 1);
+  EXPECT_EQ(jwks_->keyHint(jwt.iss_, "", "HS256"), 1);
+
+  // The key of the hint verifies the token on the calling thread.
+  tasks = 0;
+  EXPECT_EQ(verifier.verifyWithoutTimeChecking(jwt, *jwks_), Status::Ok);
+  EXPECT_EQ(tasks, 0);
+
+  // The other keys are still tried if the key of the hint fails.
+  std::string tampered = JwtTextNoKidLongExp;
+  tampered[tampered.size() - 5] ^= 1;
+  EXPECT_EQ(jwt.parseFromString(tampered), Status::Ok);
+  EXPECT_EQ(verifier.verifyWithoutTimeChecking(jwt, *jwks_),
+            Status::JwtVerificationFail);
+}
+
+TEST_F(VerifyJwkHmacBatchTest, ParallelWithTasksNotRun) {
+  // The tasks only run after the verification returned, as for an executor
+  // using the pool of the calling thread.
+  std::vector<std::function<void()>> tasks;
+  ParallelVerifier verifier(
+      [&tasks](std::function<void()> task) {
+        tasks.push_back(std::move(task));
+      },
+      1);
+
+  {
+    Jwt jwt;
+    EXPECT_EQ(jwt.parseFromString(JwtTextNoKidLongExp), Status::Ok);
+    EXPECT_EQ(verifier.verifyWithoutTimeChecking(jwt, *jwks_), Status::Ok);
+  }
+  EXPECT_EQ(tasks.size(), 1);
+  // The tasks take no key, so they may run once the token is gone.
+  for (auto& task : tasks) {
+    task();
+  }
+}
+
 }  // namespace
 }  // namespace jwt_verify
 }  // namespace google
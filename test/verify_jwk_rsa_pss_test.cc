@@ -245,6 +245,24 @@ TEST_F(VerifyJwkRsaPssTest, Ps512CorrectKidOK) {
   });
 }
 
+TEST_F(VerifyJwkRsaPssTest, ReuseVerifyContextOK) {
+  VerifyContext context;
+  for (const std::string& jwt_text : {Ps256JwtTextWithCorrectKid,
+                                      Ps384JwtTextWithCorrectKid,
+                                      Ps512JwtTextWithCorrectKid}) {
+    Jwt jwt;
+    EXPECT_EQ(jwt.parseFromString(jwt_text), Status::Ok);
+    EXPECT_EQ(verifyJwt(jwt, *jwks_, 1, kClockSkewInSecond, context),
+              Status::Ok);
+
+    fuzzJwtSignature(jwt, [this, &context](const Jwt& jwt) {
+      EXPECT_EQ(verifyJwtWithoutTimeChecking(jwt, *jwks_, context),
+                Status::JwtVerificationFail);
+    });
+    EXPECT_EQ(verifyJwtWithoutTimeChecking(jwt, *jwks_, context), Status::Ok);
+  }
+}
+
 // This set of keys and jwts were generated at https://jwt.io/
 // public key:
 //     "-----BEGIN PUBLIC KEY-----"
@@ -203,6 +203,21 @@ TEST_F(VerifyJwkRsaTest, NoKidOK) {
   });
 }
 
+TEST_F(VerifyJwkRsaTest, JwtViewOK) {
+  JwtView jwt;
+  EXPECT_EQ(jwt.parseFromString(JwtTextWithCorrectKid), Status::Ok);
+  EXPECT_EQ(verifyJwt(jwt, *jwks_, 1), Status::Ok);
+  EXPECT_EQ(verifyJwtWithoutTimeChecking(jwt, *jwks_), Status::Ok);
+
+  // Tampering with the caller's buffer invalidates the signature.
+  std::string tampered(JwtTextWithCorrectKid);
+  JwtView tampered_jwt;
+  EXPECT_EQ(tampered_jwt.parseFromString(tampered), Status::Ok);
+  tampered[tampered_jwt.signed_data_.size() - 1] ^= 1;
+  EXPECT_EQ(verifyJwtWithoutTimeChecking(tampered_jwt, *jwks_),
+            Status::JwtVerificationFail);
+}
+
 TEST_F(VerifyJwkRsaTest, NoKidLongExpOK) {
   Jwt jwt;
   EXPECT_EQ(jwt.parseFromString(JwtTextNoKidLongExp), Status::Ok);